@@ -0,0 +1,509 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+// Time local search operators evaluation on a fixed generated
+// instance. All moves from a heuristic solution are evaluated using
+// the same calls as in LocalSearch, with no gain threshold. cvrp
+// operators run on RawRoute objects and vrptw operators on TWRoute
+// objects. The gains checksum allows checking that builds compared
+// evaluate the same moves.
+//
+// Build against libvroom by running the following as a single
+// command from the src directory:
+// g++ -O3 -std=c++17 -I. ../scripts/ls_operators_benchmark.cpp
+//   -L../lib -lvroom -lpthread -lssl -lcrypto -o ls_operators_benchmark
+//
+// Usage: ls_operators_benchmark [NB_JOBS [NB_SHIPMENTS [REPEATS]]]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "algorithms/heuristics/solomon.h"
+#include "problems/cvrp/operators/cross_exchange.h"
+#include "problems/cvrp/operators/exchange.h"
+#include "problems/cvrp/operators/intra_cross_exchange.h"
+#include "problems/cvrp/operators/intra_exchange.h"
+#include "problems/cvrp/operators/intra_mixed_exchange.h"
+#include "problems/cvrp/operators/intra_or_opt.h"
+#include "problems/cvrp/operators/intra_relocate.h"
+#include "problems/cvrp/operators/mixed_exchange.h"
+#include "problems/cvrp/operators/or_opt.h"
+#include "problems/cvrp/operators/pd_shift.h"
+#include "problems/cvrp/operators/relocate.h"
+#include "problems/cvrp/operators/reverse_two_opt.h"
+#include "problems/cvrp/operators/route_exchange.h"
+#include "problems/cvrp/operators/two_opt.h"
+#include "problems/vrptw/operators/cross_exchange.h"
+#include "problems/vrptw/operators/exchange.h"
+#include "problems/vrptw/operators/intra_cross_exchange.h"
+#include "problems/vrptw/operators/intra_exchange.h"
+#include "problems/vrptw/operators/intra_mixed_exchange.h"
+#include "problems/vrptw/operators/intra_or_opt.h"
+#include "problems/vrptw/operators/intra_relocate.h"
+#include "problems/vrptw/operators/mixed_exchange.h"
+#include "problems/vrptw/operators/or_opt.h"
+#include "problems/vrptw/operators/pd_shift.h"
+#include "problems/vrptw/operators/relocate.h"
+#include "problems/vrptw/operators/reverse_two_opt.h"
+#include "problems/vrptw/operators/route_exchange.h"
+#include "problems/vrptw/operators/two_opt.h"
+#include "structures/vroom/input/input.h"
+#include "structures/vroom/solution_state.h"
+
+using namespace vroom;
+
+constexpr unsigned NB_VEHICLES = 10;
+constexpr Duration HORIZON = 100000;
+
+struct CVRPOperators {
+  using Route = RawRoute;
+  using Exchange = cvrp::Exchange;
+  using CrossExchange = cvrp::CrossExchange;
+  using MixedExchange = cvrp::MixedExchange;
+  using TwoOpt = cvrp::TwoOpt;
+  using ReverseTwoOpt = cvrp::ReverseTwoOpt;
+  using Relocate = cvrp::Relocate;
+  using OrOpt = cvrp::OrOpt;
+  using IntraExchange = cvrp::IntraExchange;
+  using IntraCrossExchange = cvrp::IntraCrossExchange;
+  using IntraMixedExchange = cvrp::IntraMixedExchange;
+  using IntraRelocate = cvrp::IntraRelocate;
+  using IntraOrOpt = cvrp::IntraOrOpt;
+  using PDShift = cvrp::PDShift;
+  using RouteExchange = cvrp::RouteExchange;
+};
+
+struct VRPTWOperators {
+  using Route = TWRoute;
+  using Exchange = vrptw::Exchange;
+  using CrossExchange = vrptw::CrossExchange;
+  using MixedExchange = vrptw::MixedExchange;
+  using TwoOpt = vrptw::TwoOpt;
+  using ReverseTwoOpt = vrptw::ReverseTwoOpt;
+  using Relocate = vrptw::Relocate;
+  using OrOpt = vrptw::OrOpt;
+  using IntraExchange = vrptw::IntraExchange;
+  using IntraCrossExchange = vrptw::IntraCrossExchange;
+  using IntraMixedExchange = vrptw::IntraMixedExchange;
+  using IntraRelocate = vrptw::IntraRelocate;
+  using IntraOrOpt = vrptw::IntraOrOpt;
+  using PDShift = vrptw::PDShift;
+  using RouteExchange = vrptw::RouteExchange;
+};
+
+// Same call sequences as in LocalSearch.
+template <class Op> Gain evaluate(Op& op) {
+  return (op.gain() > 0 and op.is_valid()) ? op.gain() : 0;
+}
+
+template <class Op> Gain evaluate_with_bound(Op& op) {
+  return (op.gain_upper_bound() > 0 and op.is_valid()) ? op.gain() : 0;
+}
+
+template <class Ops>
+void run(const Input& input, unsigned repeats, const char* name) {
+  using Route = typename Ops::Route;
+
+  auto sol = heuristics::basic<std::vector<Route>>(input, INIT::NONE, 0.3);
+  utils::SolutionState sol_state(input);
+  sol_state.setup(sol);
+
+  auto single = [&](Index v, Index rank) {
+    return input.jobs[sol[v].route[rank]].type == JOB_TYPE::SINGLE;
+  };
+  auto single_edge = [&](Index v, Index rank) {
+    return single(v, rank) and single(v, rank + 1);
+  };
+
+  std::cout << name << " operators: ns per move, moves, gains checksum\n";
+
+  // Evaluate all moves from evaluate_pair(s, t) for all vehicle
+  // pairs, repeats times.
+  auto time = [&](const char* op_name, const auto& evaluate_pair) {
+    unsigned long nb_moves = 0;
+    Gain checksum = 0;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r < repeats; ++r) {
+      for (Index s = 0; s < sol.size(); ++s) {
+        for (Index t = 0; t < sol.size(); ++t) {
+          evaluate_pair(s, t, nb_moves, checksum);
+        }
+      }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+        .count();
+    std::cout << std::left << std::setw(20) << op_name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << static_cast<double>(ns) / std::max(nb_moves, 1ul)
+              << std::setw(10) << nb_moves / repeats << std::setw(14)
+              << checksum / repeats << std::endl;
+  };
+
+  time("Exchange", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (t <= s) {
+      return;
+    }
+    for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+      for (Index t_rank = 0; t_rank < sol[t].size(); ++t_rank) {
+        if (!single(s, s_rank) or !single(t, t_rank)) {
+          continue;
+        }
+        typename Ops::Exchange
+          op(input, sol_state, sol[s], s, s_rank, sol[t], t, t_rank);
+        checksum += evaluate(op);
+        ++nb_moves;
+      }
+    }
+  });
+
+  time("CrossExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (t <= s or sol[s].size() < 2 or sol[t].size() < 2) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size() - 1; ++s_rank) {
+           for (Index t_rank = 0; t_rank < sol[t].size() - 1; ++t_rank) {
+             if (!single_edge(s, s_rank) or !single_edge(t, t_rank)) {
+               continue;
+             }
+             typename Ops::CrossExchange op(input,
+                                            sol_state,
+                                            sol[s],
+                                            s,
+                                            s_rank,
+                                            sol[t],
+                                            t,
+                                            t_rank,
+                                            true,
+                                            true);
+             checksum += evaluate_with_bound(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("MixedExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s == t or sol[t].size() < 2) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+           for (Index t_rank = 0; t_rank < sol[t].size() - 1; ++t_rank) {
+             if (!single(s, s_rank) or !single_edge(t, t_rank)) {
+               continue;
+             }
+             typename Ops::MixedExchange op(input,
+                                            sol_state,
+                                            sol[s],
+                                            s,
+                                            s_rank,
+                                            sol[t],
+                                            t,
+                                            t_rank,
+                                            true);
+             checksum += evaluate_with_bound(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("TwoOpt", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (t <= s) {
+      return;
+    }
+    for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+      if (sol[s].has_pending_delivery_after_rank(s_rank)) {
+        continue;
+      }
+      for (Index t_rank = 0; t_rank < sol[t].size(); ++t_rank) {
+        if (sol[t].has_pending_delivery_after_rank(t_rank)) {
+          continue;
+        }
+        typename Ops::TwoOpt
+          op(input, sol_state, sol[s], s, s_rank, sol[t], t, t_rank);
+        checksum += evaluate(op);
+        ++nb_moves;
+      }
+    }
+  });
+
+  time("ReverseTwoOpt",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s == t) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+           if (sol[s].has_delivery_after_rank(s_rank)) {
+             continue;
+           }
+           for (Index t_rank = 0; t_rank < sol[t].size(); ++t_rank) {
+             if (sol[t].has_pickup_up_to_rank(t_rank)) {
+               continue;
+             }
+             typename Ops::ReverseTwoOpt
+               op(input, sol_state, sol[s], s, s_rank, sol[t], t, t_rank);
+             checksum += evaluate(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("Relocate", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (s == t) {
+      return;
+    }
+    for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+      if (!single(s, s_rank)) {
+        continue;
+      }
+      for (Index t_rank = 0; t_rank <= sol[t].size(); ++t_rank) {
+        typename Ops::Relocate
+          op(input, sol_state, sol[s], s, s_rank, sol[t], t, t_rank);
+        checksum += evaluate(op);
+        ++nb_moves;
+      }
+    }
+  });
+
+  time("OrOpt", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (s == t or sol[s].size() < 2) {
+      return;
+    }
+    for (Index s_rank = 0; s_rank < sol[s].size() - 1; ++s_rank) {
+      if (!single_edge(s, s_rank)) {
+        continue;
+      }
+      for (Index t_rank = 0; t_rank <= sol[t].size(); ++t_rank) {
+        typename Ops::OrOpt
+          op(input, sol_state, sol[s], s, s_rank, sol[t], t, t_rank);
+        checksum += evaluate_with_bound(op);
+        ++nb_moves;
+      }
+    }
+  });
+
+  time("IntraExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s != t or sol[s].size() < 3) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size() - 2; ++s_rank) {
+           for (Index t_rank = s_rank + 2; t_rank < sol[s].size(); ++t_rank) {
+             if (!single(s, s_rank) or !single(s, t_rank)) {
+               continue;
+             }
+             typename Ops::IntraExchange
+               op(input, sol_state, sol[s], s, s_rank, t_rank);
+             checksum += evaluate(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("IntraCrossExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s != t or sol[s].size() < 5) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank <= sol[s].size() - 4; ++s_rank) {
+           for (Index t_rank = s_rank + 3; t_rank < sol[s].size() - 1;
+                ++t_rank) {
+             if (!single_edge(s, s_rank) or !single_edge(s, t_rank)) {
+               continue;
+             }
+             typename Ops::IntraCrossExchange
+               op(input, sol_state, sol[s], s, s_rank, t_rank, true, true);
+             checksum += evaluate_with_bound(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("IntraMixedExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s != t or sol[s].size() < 4) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+           for (Index t_rank = 0; t_rank < sol[s].size() - 1; ++t_rank) {
+             if ((t_rank <= s_rank + 1 and s_rank <= t_rank + 2) or
+                 !single(s, s_rank) or !single_edge(s, t_rank)) {
+               continue;
+             }
+             typename Ops::IntraMixedExchange
+               op(input, sol_state, sol[s], s, s_rank, t_rank, true);
+             checksum += evaluate_with_bound(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("IntraRelocate",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (s != t or sol[s].size() < 2) {
+           return;
+         }
+         for (Index s_rank = 0; s_rank < sol[s].size(); ++s_rank) {
+           if (!single(s, s_rank)) {
+             continue;
+           }
+           for (Index t_rank = 0; t_rank < sol[s].size(); ++t_rank) {
+             if (t_rank == s_rank) {
+               continue;
+             }
+             typename Ops::IntraRelocate
+               op(input, sol_state, sol[s], s, s_rank, t_rank);
+             checksum += evaluate(op);
+             ++nb_moves;
+           }
+         }
+       });
+
+  time("IntraOrOpt", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (s != t or sol[s].size() < 4) {
+      return;
+    }
+    for (Index s_rank = 0; s_rank < sol[s].size() - 1; ++s_rank) {
+      if (!single_edge(s, s_rank)) {
+        continue;
+      }
+      for (Index t_rank = 0; t_rank <= sol[s].size() - 2; ++t_rank) {
+        if (t_rank == s_rank) {
+          continue;
+        }
+        typename Ops::IntraOrOpt
+          op(input, sol_state, sol[s], s, s_rank, t_rank, true);
+        checksum += evaluate_with_bound(op);
+        ++nb_moves;
+      }
+    }
+  });
+
+  time("PDShift", [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+    if (s == t) {
+      return;
+    }
+    for (Index s_p_rank = 0; s_p_rank < sol[s].size(); ++s_p_rank) {
+      if (input.jobs[sol[s].route[s_p_rank]].type != JOB_TYPE::PICKUP) {
+        continue;
+      }
+      typename Ops::PDShift op(input,
+                               sol_state,
+                               sol[s],
+                               s,
+                               s_p_rank,
+                               sol_state.matching_delivery_rank[s][s_p_rank],
+                               sol[t],
+                               t,
+                               0);
+      checksum += evaluate(op);
+      ++nb_moves;
+    }
+  });
+
+  time("RouteExchange",
+       [&](Index s, Index t, auto& nb_moves, auto& checksum) {
+         if (t <= s or (sol[s].size() == 0 and sol[t].size() == 0)) {
+           return;
+         }
+         typename Ops::RouteExchange op(input, sol_state, sol[s], s, sol[t], t);
+         checksum += evaluate(op);
+         ++nb_moves;
+       });
+}
+
+int main(int argc, char** argv) {
+  const unsigned nb_jobs = (argc > 1) ? std::atoi(argv[1]) : 200;
+  const unsigned nb_shipments = (argc > 2) ? std::atoi(argv[2]) : 20;
+  const unsigned repeats = (argc > 3) ? std::atoi(argv[3]) : 20;
+
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> coord(0, 1000);
+  std::uniform_int_distribution<Duration> tw_start(0, HORIZON / 2);
+
+  Input input(1);
+
+  // Capacity and time windows are loose enough for the heuristic to
+  // spread all jobs on available vehicles.
+  Amount capacity(1);
+  capacity[0] = (nb_jobs + 2 * nb_shipments) / NB_VEHICLES + 10;
+  Location depot(0);
+  for (unsigned v = 0; v < NB_VEHICLES; ++v) {
+    input.add_vehicle(Vehicle(v,
+                              depot,
+                              depot,
+                              capacity,
+                              Skills(),
+                              TimeWindow(0, 2 * HORIZON)));
+  }
+
+  auto get_tws = [&]() {
+    const auto start = tw_start(gen);
+    return std::vector<TimeWindow>({TimeWindow(start, start + HORIZON / 2)});
+  };
+
+  Amount one(1);
+  one[0] = 1;
+  Index location = 1;
+  for (unsigned j = 0; j < nb_jobs; ++j) {
+    input.add_job(
+      Job(j, Location(location++), 10, one, Amount(1), Skills(), 0, get_tws()));
+  }
+  for (unsigned s = 0; s < nb_shipments; ++s) {
+    const Id id = nb_jobs + s;
+    const auto tws = get_tws();
+    const Index pickup_location = location++;
+    const Index delivery_location = location++;
+    input.add_shipment(Job(id,
+                           JOB_TYPE::PICKUP,
+                           Location(pickup_location),
+                           10,
+                           one,
+                           Skills(),
+                           0,
+                           tws),
+                       Job(id,
+                           JOB_TYPE::DELIVERY,
+                           Location(delivery_location),
+                           10,
+                           one,
+                           Skills(),
+                           0,
+                           tws));
+  }
+
+  std::vector<std::pair<double, double>> points(location);
+  for (auto& p : points) {
+    p = {coord(gen), coord(gen)};
+  }
+  Matrix<Cost> m(location);
+  for (Index i = 0; i < location; ++i) {
+    for (Index j = 0; j < location; ++j) {
+      m[i][j] = static_cast<Cost>(std::hypot(points[i].first - points[j].first,
+                                             points[i].second -
+                                               points[j].second));
+    }
+  }
+  input.set_matrix(std::move(m));
+
+  // Quick solve to set up vehicle/job compatibility in input.
+  input.solve(0, 1);
+
+  run<CVRPOperators>(input, repeats, "cvrp (RawRoute)");
+  run<VRPTWOperators>(input, repeats, "vrptw (TWRoute)");
+
+  return 0;
+}
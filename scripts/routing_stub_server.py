@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+
+# Minimal OSRM-like server used to check HttpWrapper behaviour against
+# the various ways a server may frame responses.
+#
+# Usage:
+#   routing_stub_server.py [--port PORT] [--mode length|chunked|http10]
+#                          [--tls CERT KEY]
+#
+# Modes:
+#  - length: HTTP/1.1 keep-alive responses with Content-Length
+#  - chunked: HTTP/1.1 keep-alive responses with chunked encoding
+#  - http10: HTTP/1.0 responses without Content-Length, the connection
+#    is closed after each response
+#
+# With --tls, the server speaks HTTPS (vroom only uses HTTPS on port
+# 443, e.g. run as root with --port 443 and --tls).
+#
+# Each request is logged on stderr with the client port, so that
+# connection reuse shows up as repeated ports, and with TLS session
+# resumption status.
+#
+# Example:
+#   ./scripts/routing_stub_server.py --port 5000 --mode chunked &
+#   ./bin/vroom -a car:127.0.0.1 -p car:5000 -i docs/example_1.json -g
+
+import argparse
+import json
+import math
+import ssl
+import sys
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlsplit
+
+CHUNK_SIZE = 37
+
+log_lock = threading.Lock()
+
+
+def duration(a, b):
+    return round(math.hypot(a[0] - b[0], a[1] - b[1]) * 1000, 1)
+
+
+def table_response(coords, query):
+    everyone = list(range(len(coords)))
+    sources = everyone
+    if "sources" in query:
+        sources = [int(i) for i in query["sources"][0].split(";")]
+    destinations = everyone
+    if "destinations" in query:
+        destinations = [int(i) for i in query["destinations"][0].split(";")]
+
+    body = {
+        "code": "Ok",
+        "durations": [
+            [duration(coords[i], coords[j]) for j in destinations] for i in sources
+        ],
+    }
+    if "annotations" in query and "distance" in query["annotations"][0]:
+        body["distances"] = [
+            [10 * duration(coords[i], coords[j]) for j in destinations]
+            for i in sources
+        ]
+    return body
+
+
+def route_response(coords):
+    legs = [duration(coords[k], coords[k + 1]) for k in range(len(coords) - 1)]
+    return {
+        "code": "Ok",
+        "routes": [
+            {
+                "duration": sum(legs),
+                "distance": 10 * sum(legs),
+                "geometry": "_p~iF~ps|U_ulLnnqC_mqNvxq`@",
+                "legs": [{"distance": 10 * leg} for leg in legs],
+            }
+        ],
+    }
+
+
+def make_handler(mode):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.0" if mode == "http10" else "HTTP/1.1"
+
+        def log_message(self, *args):
+            pass
+
+        def do_GET(self):
+            url = urlsplit(self.path)
+            # Path is /{service}/v1/{profile}/{coordinates}.
+            parts = url.path.split("/")
+            service = parts[1]
+            coords = [tuple(map(float, c.split(","))) for c in parts[4].split(";")]
+            query = parse_qs(url.query)
+
+            reused = ""
+            if isinstance(self.connection, ssl.SSLSocket):
+                reused = " session_reused={}".format(self.connection.session_reused)
+            with log_lock:
+                print(
+                    "{} locations={} port={}{}".format(
+                        service, len(coords), self.client_address[1], reused
+                    ),
+                    file=sys.stderr,
+                    flush=True,
+                )
+
+            if service == "table":
+                body = table_response(coords, query)
+            elif service == "route":
+                body = route_response(coords)
+            else:
+                self.send_error(400)
+                return
+
+            data = json.dumps(body).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            if mode == "chunked":
+                self.send_header("Transfer-Encoding", "chunked")
+                self.end_headers()
+                for k in range(0, len(data), CHUNK_SIZE):
+                    chunk = data[k : k + CHUNK_SIZE]
+                    self.wfile.write(b"%x\r\n%s\r\n" % (len(chunk), chunk))
+                self.wfile.write(b"0\r\n\r\n")
+            elif mode == "length":
+                self.send_header("Content-Length", str(len(data)))
+                self.end_headers()
+                self.wfile.write(data)
+            else:
+                self.end_headers()
+                self.wfile.write(data)
+
+    return Handler
+
+
+class Server(ThreadingHTTPServer):
+    def shutdown_request(self, request):
+        # Send TLS close notification before closing connection, as
+        # clients discard sessions on truncated connections.
+        if isinstance(request, ssl.SSLSocket):
+            try:
+                request.unwrap()
+            except (ssl.SSLError, OSError):
+                pass
+        super().shutdown_request(request)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stub OSRM server.")
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument(
+        "--mode", choices=["length", "chunked", "http10"], default="length"
+    )
+    parser.add_argument("--tls", nargs=2, metavar=("CERT", "KEY"))
+    args = parser.parse_args()
+
+    server = Server(("127.0.0.1", args.port), make_handler(args.mode))
+    if args.tls:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.tls[0], args.tls[1])
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
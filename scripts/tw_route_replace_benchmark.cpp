@@ -0,0 +1,122 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+// Time TWRoute::replace on a fixed generated route, alternating
+// same-size replacements (segment reversal) with shrinking and
+// growing ones (removing then adding back a job).
+//
+// Build against libvroom by running the following as a single
+// command from the src directory:
+// g++ -O3 -std=c++17 -I. ../scripts/tw_route_replace_benchmark.cpp
+//   -L../lib -lvroom -lpthread -lssl -lcrypto -o tw_route_replace_benchmark
+//
+// Usage: tw_route_replace_benchmark [ROUTE_SIZE [NB_BREAKS]]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "structures/vroom/input/input.h"
+#include "structures/vroom/tw_route.h"
+
+constexpr unsigned ITERATIONS = 200000;
+constexpr unsigned SEGMENT_SIZE = 4;
+
+int main(int argc, char** argv) {
+  const unsigned route_size = (argc > 1) ? std::atoi(argv[1]) : 100;
+  const unsigned nb_breaks = (argc > 2) ? std::atoi(argv[2]) : 0;
+
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<vroom::Cost> travel(1, 100);
+
+  vroom::Input input(0);
+
+  // Wide time windows keep all replacements valid while still
+  // requiring dates propagation.
+  const vroom::Duration horizon = 1000 * route_size;
+  std::vector<vroom::Break> breaks;
+  for (unsigned b = 0; b < nb_breaks; ++b) {
+    breaks.emplace_back(b, std::vector<vroom::TimeWindow>({{0, horizon}}), 10);
+  }
+  vroom::Location depot(0);
+  input.add_vehicle(vroom::Vehicle(0,
+                                   depot,
+                                   depot,
+                                   vroom::Amount(0),
+                                   vroom::Skills(),
+                                   vroom::TimeWindow(0, 2 * horizon),
+                                   breaks));
+
+  for (unsigned j = 1; j <= route_size; ++j) {
+    input.add_job(vroom::Job(j,
+                             vroom::Location(j),
+                             10,
+                             vroom::Amount(0),
+                             vroom::Amount(0),
+                             vroom::Skills(),
+                             0,
+                             {vroom::TimeWindow(0, horizon)}));
+  }
+
+  vroom::Matrix<vroom::Cost> m(route_size + 1);
+  for (unsigned i = 0; i <= route_size; ++i) {
+    for (unsigned j = 0; j <= route_size; ++j) {
+      m[i][j] = (i == j) ? 0 : travel(gen);
+    }
+  }
+  input.set_matrix(std::move(m));
+
+  std::vector<vroom::Index> jobs(route_size);
+  for (unsigned j = 0; j < route_size; ++j) {
+    jobs[j] = j;
+  }
+
+  vroom::TWRoute tw_r(input, 0);
+  tw_r.replace(input, jobs.begin(), jobs.end(), 0, 0);
+
+  std::uniform_int_distribution<unsigned> rank(0, route_size - SEGMENT_SIZE);
+  std::vector<vroom::Index> segment;
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned i = 0; i < ITERATIONS; ++i) {
+    const vroom::Index first_rank = rank(gen);
+    const vroom::Index last_rank = first_rank + SEGMENT_SIZE;
+
+    segment.assign(tw_r.route.rbegin() + (route_size - last_rank),
+                   tw_r.route.rbegin() + (route_size - first_rank));
+    if (i % 2 == 0) {
+      tw_r.replace(input,
+                   segment.begin(),
+                   segment.end(),
+                   first_rank,
+                   last_rank);
+    } else {
+      tw_r.replace(input,
+                   segment.begin(),
+                   segment.end() - 1,
+                   first_rank,
+                   last_rank);
+      tw_r.replace(input,
+                   segment.end() - 1,
+                   segment.end(),
+                   first_rank,
+                   first_rank);
+    }
+  }
+  const auto end = std::chrono::high_resolution_clock::now();
+
+  const auto ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  std::cout << "Route size " << route_size << ", " << nb_breaks
+            << " break(s): " << ns / (1.5 * ITERATIONS)
+            << " ns per replace" << std::endl;
+
+  return 0;
+}
@@ -7,7 +7,9 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
 #include <numeric>
+#include <tuple>
 
 #include "algorithms/local_search/local_search.h"
 #include "algorithms/local_search/operator.h"
@@ -40,10 +42,15 @@ All rights reserved (see LICENSE).
 #include "problems/vrptw/operators/route_exchange.h"
 #include "problems/vrptw/operators/two_opt.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 namespace ls {
 
+// A seed is abandoned after its first descent if its cost is more
+// than this ratio above the incumbent cost.
+constexpr double MAX_INCUMBENT_COST_GAP = 0.25;
+
 template <class Route,
           class Exchange,
           class CrossExchange,
@@ -75,20 +82,31 @@ LocalSearch<Route,
             PDShift,
             RouteExchange>::LocalSearch(const Input& input,
                                         std::vector<Route>& sol,
-                                        unsigned max_nb_jobs_removal)
+                                        unsigned max_nb_jobs_removal,
+                                        unsigned nb_threads,
+                                        const Deadline& deadline,
+                                        utils::SharedIndicators* incumbent)
   : _input(input),
     _matrix(_input.get_matrix()),
     _nb_vehicles(_input.vehicles.size()),
     _max_nb_jobs_removal(max_nb_jobs_removal),
+    _nb_threads(nb_threads),
+    _deadline(deadline),
+    _incumbent(incumbent),
     _all_routes(_nb_vehicles),
     _sol_state(input),
     _sol(sol),
-    _best_sol(sol) {
+    _best_sol(sol),
+    _modified_since_best(_nb_vehicles, false) {
   // Initialize all route indices.
   std::iota(_all_routes.begin(), _all_routes.end(), 0);
 
   // Setup solution state.
   _sol_state.setup(_sol);
+  for (auto& r : _sol) {
+    r.pop_modified_range();
+  }
+  _best_unassigned = _sol_state.unassigned;
 
   _best_sol_indicators.priority_sum =
     std::accumulate(_sol.begin(), _sol.end(), 0, [&](auto sum, const auto& r) {
@@ -396,6 +414,71 @@ void LocalSearch<Route,
   } while (job_added);
 }
 
+template <class Route,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+bool LocalSearch<Route,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::creates_short_edge(Index v,
+                                                    Index first_rank,
+                                                    Index last_rank,
+                                                    Index first_job,
+                                                    Index last_job) const {
+  if (!_input.has_granular_neighbourhoods()) {
+    return true;
+  }
+
+  const auto& route = _sol[v].route;
+  bool has_previous = (first_rank > 0);
+  bool has_next = (last_rank < route.size());
+
+  if (!has_previous and !has_next) {
+    return true;
+  }
+
+  if (has_previous) {
+    const auto previous = route[first_rank - 1];
+    if (_input.is_short_edge(previous, first_job) or
+        _input.is_short_edge(previous, last_job)) {
+      return true;
+    }
+  }
+
+  if (has_next) {
+    const auto next = route[last_rank];
+    if (_input.is_short_edge(last_job, next) or
+        _input.is_short_edge(first_job, next)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 template <class Route,
           class Exchange,
           class CrossExchange,
@@ -426,10 +509,10 @@ void LocalSearch<Route,
                  IntraOrOpt,
                  PDShift,
                  RouteExchange>::run_ls_step() {
-  std::vector<std::vector<std::unique_ptr<Operator>>> best_ops(_nb_vehicles);
-  for (std::size_t v = 0; v < _nb_vehicles; ++v) {
-    best_ops[v] = std::vector<std::unique_ptr<Operator>>(_nb_vehicles);
-  }
+  // Best move found for each source/target pair, only turned into an
+  // operator when applied.
+  std::vector<std::vector<Move>> best_moves(_nb_vehicles,
+                                            std::vector<Move>(_nb_vehicles));
 
   // List of source/target pairs we need to test (all related vehicles
   // at first).
@@ -445,239 +528,414 @@ void LocalSearch<Route,
   std::vector<std::vector<Gain>> best_gains(_nb_vehicles,
                                             std::vector<Gain>(_nb_vehicles, 0));
 
-  Gain best_gain = 1;
-
-  while (best_gain > 0) {
-    // Operators applied to a pair of (different) routes.
+  // Exchange stuff
+  auto try_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.second <= s_t.first or // This operator is symmetric.
+        _sol[s_t.first].size() == 0 or _sol[s_t.second].size() == 0) {
+      return;
+    }
 
-    if (_input.has_jobs()) {
-      // Move(s) that don't make sense for shipment-only instances.
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
+      const auto& s_job_rank = _sol[s_t.first].route[s_rank];
+      if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
+          !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
+        // Don't try moving (part of) a shipment or an
+        // incompatible job.
+        continue;
+      }
 
-      // Exchange stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.second <= s_t.first or // This operator is symmetric.
-            _sol[s_t.first].size() == 0 or _sol[s_t.second].size() == 0) {
+      for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size(); ++t_rank) {
+        const auto& t_job_rank = _sol[s_t.second].route[t_rank];
+        if (_input.jobs[t_job_rank].type != JOB_TYPE::SINGLE or
+            !_input.vehicle_ok_with_job(s_t.first, t_job_rank)) {
+          // Don't try moving (part of) a shipment or an
+          // incompatible job.
           continue;
         }
 
-        for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
-          const auto& s_job_rank = _sol[s_t.first].route[s_rank];
-          if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
-              !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
-            // Don't try moving (part of) a shipment or an
-            // incompatible job.
-            continue;
-          }
+        if (!creates_short_edge(s_t.second,
+                                t_rank,
+                                t_rank + 1,
+                                s_job_rank,
+                                s_job_rank) and
+            !creates_short_edge(s_t.first,
+                                s_rank,
+                                s_rank + 1,
+                                t_job_rank,
+                                t_job_rank)) {
+          continue;
+        }
 
-          for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size();
-               ++t_rank) {
-            const auto& t_job_rank = _sol[s_t.second].route[t_rank];
-            if (_input.jobs[t_job_rank].type != JOB_TYPE::SINGLE or
-                !_input.vehicle_ok_with_job(s_t.first, t_job_rank)) {
-              // Don't try moving (part of) a shipment or an
-              // incompatible job.
-              continue;
-            }
+        Exchange r(_input,
+                   _sol_state,
+                   _sol[s_t.first],
+                   s_t.first,
+                   s_rank,
+                   _sol[s_t.second],
+                   s_t.second,
+                   t_rank);
 
-            Exchange r(_input,
-                       _sol_state,
-                       _sol[s_t.first],
-                       s_t.first,
-                       s_rank,
-                       _sol[s_t.second],
-                       s_t.second,
-                       t_rank);
-
-            if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
-              best_gains[s_t.first][s_t.second] = r.gain();
-              best_ops[s_t.first][s_t.second] = std::make_unique<Exchange>(r);
-            }
-          }
+        if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          best_gains[s_t.first][s_t.second] = r.gain();
+          best_moves[s_t.first][s_t.second] =
+            Move{OPERATOR::EXCHANGE, s_rank, t_rank};
         }
       }
     }
+  };
 
-    // CROSS-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.second <= s_t.first or // This operator is symmetric.
-          _sol[s_t.first].size() < 2 or _sol[s_t.second].size() < 2) {
+  // CROSS-exchange stuff
+  auto try_cross_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.second <= s_t.first or // This operator is symmetric.
+        _sol[s_t.first].size() < 2 or _sol[s_t.second].size() < 2) {
+      return;
+    }
+
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
+      if (!_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_rank]) or
+          !_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_rank + 1])) {
         continue;
       }
 
-      for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
-        if (!_input.vehicle_ok_with_job(s_t.second,
-                                        _sol[s_t.first].route[s_rank]) or
-            !_input.vehicle_ok_with_job(s_t.second,
-                                        _sol[s_t.first].route[s_rank + 1])) {
+      const auto& job_s_type =
+        _input.jobs[_sol[s_t.first].route[s_rank]].type;
+
+      bool both_s_single =
+        (job_s_type == JOB_TYPE::SINGLE) and
+        (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
+         JOB_TYPE::SINGLE);
+
+      bool is_s_pickup =
+        (job_s_type == JOB_TYPE::PICKUP) and
+        (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
+
+      if (!both_s_single and !is_s_pickup) {
+        continue;
+      }
+
+      for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size() - 1;
+           ++t_rank) {
+        if (!_input.vehicle_ok_with_job(s_t.first,
+                                        _sol[s_t.second].route[t_rank]) or
+            !_input.vehicle_ok_with_job(s_t.first,
+                                        _sol[s_t.second].route[t_rank + 1])) {
           continue;
         }
 
-        const auto& job_s_type =
-          _input.jobs[_sol[s_t.first].route[s_rank]].type;
+        const auto& job_t_type =
+          _input.jobs[_sol[s_t.second].route[t_rank]].type;
 
-        bool both_s_single =
-          (job_s_type == JOB_TYPE::SINGLE) and
-          (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
+        bool both_t_single =
+          (job_t_type == JOB_TYPE::SINGLE) and
+          (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
            JOB_TYPE::SINGLE);
 
-        bool is_s_pickup =
-          (job_s_type == JOB_TYPE::PICKUP) and
-          (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
+        bool is_t_pickup =
+          (job_t_type == JOB_TYPE::PICKUP) and
+          (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
+           t_rank + 1);
 
-        if (!both_s_single and !is_s_pickup) {
+        if (!both_t_single and !is_t_pickup) {
           continue;
         }
 
-        for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size() - 1;
-             ++t_rank) {
-          if (!_input.vehicle_ok_with_job(s_t.first,
-                                          _sol[s_t.second].route[t_rank]) or
-              !_input.vehicle_ok_with_job(s_t.first,
-                                          _sol[s_t.second].route[t_rank + 1])) {
-            continue;
-          }
+        const auto& s_route = _sol[s_t.first].route;
+        const auto& t_route = _sol[s_t.second].route;
+        if (!creates_short_edge(s_t.second,
+                                t_rank,
+                                t_rank + 2,
+                                s_route[s_rank],
+                                s_route[s_rank + 1]) and
+            !creates_short_edge(s_t.first,
+                                s_rank,
+                                s_rank + 2,
+                                t_route[t_rank],
+                                t_route[t_rank + 1])) {
+          continue;
+        }
 
-          const auto& job_t_type =
-            _input.jobs[_sol[s_t.second].route[t_rank]].type;
+        CrossExchange r(_input,
+                        _sol_state,
+                        _sol[s_t.first],
+                        s_t.first,
+                        s_rank,
+                        _sol[s_t.second],
+                        s_t.second,
+                        t_rank,
+                        !is_s_pickup,
+                        !is_t_pickup);
+
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.second] = Move{OPERATOR::CROSS_EXCHANGE,
+                                                   s_rank,
+                                                   t_rank,
+                                                   !is_s_pickup,
+                                                   !is_t_pickup};
+        }
+      }
+    }
+  };
 
-          bool both_t_single =
-            (job_t_type == JOB_TYPE::SINGLE) and
-            (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
-             JOB_TYPE::SINGLE);
+  // Mixed-exchange stuff
+  auto try_mixed_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first == s_t.second or _sol[s_t.first].size() == 0 or
+        _sol[s_t.second].size() < 2) {
+      return;
+    }
 
-          bool is_t_pickup =
-            (job_t_type == JOB_TYPE::PICKUP) and
-            (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
-             t_rank + 1);
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
+      const auto& s_job_rank = _sol[s_t.first].route[s_rank];
+      if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
+          !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
+        // Don't try moving part of a shipment or an incompatible
+        // job.
+        continue;
+      }
 
-          if (!both_t_single and !is_t_pickup) {
-            continue;
-          }
+      for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size() - 1;
+           ++t_rank) {
+        if (!_input.vehicle_ok_with_job(s_t.first,
+                                        _sol[s_t.second].route[t_rank]) or
+            !_input
+               .vehicle_ok_with_job(s_t.first,
+                                    _sol[s_t.second].route[t_rank + 1])) {
+          continue;
+        }
 
-          CrossExchange r(_input,
-                          _sol_state,
-                          _sol[s_t.first],
-                          s_t.first,
-                          s_rank,
-                          _sol[s_t.second],
-                          s_t.second,
-                          t_rank,
-                          !is_s_pickup,
-                          !is_t_pickup);
-
-          auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
-              r.gain() > current_best) {
-            current_best = r.gain();
-            best_ops[s_t.first][s_t.second] =
-              std::make_unique<CrossExchange>(r);
-          }
+        const auto& job_t_type =
+          _input.jobs[_sol[s_t.second].route[t_rank]].type;
+
+        bool both_t_single =
+          (job_t_type == JOB_TYPE::SINGLE) and
+          (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
+           JOB_TYPE::SINGLE);
+
+        bool is_t_pickup =
+          (job_t_type == JOB_TYPE::PICKUP) and
+          (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
+           t_rank + 1);
+
+        if (!both_t_single and !is_t_pickup) {
+          continue;
+        }
+
+        const auto& t_route = _sol[s_t.second].route;
+        if (!creates_short_edge(s_t.second,
+                                t_rank,
+                                t_rank + 2,
+                                s_job_rank,
+                                s_job_rank) and
+            !creates_short_edge(s_t.first,
+                                s_rank,
+                                s_rank + 1,
+                                t_route[t_rank],
+                                t_route[t_rank + 1])) {
+          continue;
+        }
+
+        MixedExchange r(_input,
+                        _sol_state,
+                        _sol[s_t.first],
+                        s_t.first,
+                        s_rank,
+                        _sol[s_t.second],
+                        s_t.second,
+                        t_rank,
+                        !is_t_pickup);
+
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.second] = Move{OPERATOR::MIXED_EXCHANGE,
+                                                   s_rank,
+                                                   t_rank,
+                                                   false,
+                                                   !is_t_pickup};
         }
       }
     }
+  };
 
-    if (_input.has_jobs()) {
-      // Mixed-exchange stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or _sol[s_t.first].size() == 0 or
-            _sol[s_t.second].size() < 2) {
+  // 2-opt* stuff
+  auto try_two_opt = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.second <= s_t.first) {
+      // This operator is symmetric.
+      return;
+    }
+
+    // Determine first ranks for inner loops based on vehicles/jobs
+    // compatibility along the routes.
+    unsigned first_s_rank = 0;
+    const auto first_s_candidate =
+      _sol_state.bwd_skill_rank[s_t.first][s_t.second];
+    if (first_s_candidate > 0) {
+      first_s_rank = first_s_candidate - 1;
+    }
+
+    int first_t_rank = 0;
+    const auto first_t_candidate =
+      _sol_state.bwd_skill_rank[s_t.second][s_t.first];
+    if (first_t_candidate > 0) {
+      first_t_rank = first_t_candidate - 1;
+    }
+
+    for (unsigned s_rank = first_s_rank; s_rank < _sol[s_t.first].size();
+         ++s_rank) {
+      if (_sol[s_t.first].has_pending_delivery_after_rank(s_rank)) {
+        continue;
+      }
+
+      for (int t_rank = _sol[s_t.second].size() - 1; t_rank >= first_t_rank;
+           --t_rank) {
+        if (_sol[s_t.second].has_pending_delivery_after_rank(t_rank)) {
           continue;
         }
 
-        for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
-          const auto& s_job_rank = _sol[s_t.first].route[s_rank];
-          if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
-              !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
-            // Don't try moving part of a shipment or an incompatible
-            // job.
+        if (_input.has_granular_neighbourhoods()) {
+          // New edges between jobs (if any) are from s_rank to
+          // t_rank + 1 and from t_rank to s_rank + 1.
+          const auto& s_route = _sol[s_t.first].route;
+          const auto& t_route = _sol[s_t.second].route;
+          bool s_has_next = (s_rank + 1 < s_route.size());
+          bool t_has_next = (t_rank + 1 < static_cast<int>(t_route.size()));
+
+          bool short_edge = !s_has_next and !t_has_next;
+          if (t_has_next) {
+            short_edge =
+              short_edge ||
+              _input.is_short_edge(s_route[s_rank], t_route[t_rank + 1]);
+          }
+          if (s_has_next) {
+            short_edge =
+              short_edge ||
+              _input.is_short_edge(t_route[t_rank], s_route[s_rank + 1]);
+          }
+          if (!short_edge) {
             continue;
           }
+        }
 
-          for (unsigned t_rank = 0; t_rank < _sol[s_t.second].size() - 1;
-               ++t_rank) {
-            if (!_input.vehicle_ok_with_job(s_t.first,
-                                            _sol[s_t.second].route[t_rank]) or
-                !_input
-                   .vehicle_ok_with_job(s_t.first,
-                                        _sol[s_t.second].route[t_rank + 1])) {
-              continue;
-            }
+        TwoOpt r(_input,
+                 _sol_state,
+                 _sol[s_t.first],
+                 s_t.first,
+                 s_rank,
+                 _sol[s_t.second],
+                 s_t.second,
+                 t_rank);
+
+        if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          best_gains[s_t.first][s_t.second] = r.gain();
+          best_moves[s_t.first][s_t.second] =
+            Move{OPERATOR::TWO_OPT, s_rank, static_cast<unsigned>(t_rank)};
+        }
+      }
+    }
+  };
 
-            const auto& job_t_type =
-              _input.jobs[_sol[s_t.second].route[t_rank]].type;
+  // Reverse 2-opt* stuff
+  auto try_reverse_two_opt = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first == s_t.second) {
+      return;
+    }
 
-            bool both_t_single =
-              (job_t_type == JOB_TYPE::SINGLE) and
-              (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
-               JOB_TYPE::SINGLE);
+    // Determine first rank for inner loop based on vehicles/jobs
+    // compatibility along the routes.
+    unsigned first_s_rank = 0;
+    const auto first_s_candidate =
+      _sol_state.bwd_skill_rank[s_t.first][s_t.second];
+    if (first_s_candidate > 0) {
+      first_s_rank = first_s_candidate - 1;
+    }
 
-            bool is_t_pickup =
-              (job_t_type == JOB_TYPE::PICKUP) and
-              (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
-               t_rank + 1);
+    for (unsigned s_rank = first_s_rank; s_rank < _sol[s_t.first].size();
+         ++s_rank) {
+      if (_sol[s_t.first].has_delivery_after_rank(s_rank)) {
+        continue;
+      }
 
-            if (!both_t_single and !is_t_pickup) {
-              continue;
-            }
+      for (unsigned t_rank = 0;
+           t_rank < _sol_state.fwd_skill_rank[s_t.second][s_t.first];
+           ++t_rank) {
+        if (_sol[s_t.second].has_pickup_up_to_rank(t_rank)) {
+          continue;
+        }
 
-            MixedExchange r(_input,
-                            _sol_state,
-                            _sol[s_t.first],
-                            s_t.first,
-                            s_rank,
-                            _sol[s_t.second],
-                            s_t.second,
-                            t_rank,
-                            !is_t_pickup);
-
-            auto& current_best = best_gains[s_t.first][s_t.second];
-            if (r.gain_upper_bound() > current_best and r.is_valid() and
-                r.gain() > current_best) {
-              current_best = r.gain();
-              best_ops[s_t.first][s_t.second] =
-                std::make_unique<MixedExchange>(r);
-            }
+        if (_input.has_granular_neighbourhoods()) {
+          // New edges between jobs are from s_rank to t_rank and
+          // (if any) from s_rank + 1 to t_rank + 1.
+          const auto& s_route = _sol[s_t.first].route;
+          const auto& t_route = _sol[s_t.second].route;
+
+          bool short_edge =
+            _input.is_short_edge(s_route[s_rank], t_route[t_rank]);
+          if (s_rank + 1 < s_route.size() and t_rank + 1 < t_route.size()) {
+            short_edge =
+              short_edge ||
+              _input.is_short_edge(s_route[s_rank + 1], t_route[t_rank + 1]);
+          }
+          if (!short_edge) {
+            continue;
           }
         }
+
+        ReverseTwoOpt r(_input,
+                        _sol_state,
+                        _sol[s_t.first],
+                        s_t.first,
+                        s_rank,
+                        _sol[s_t.second],
+                        s_t.second,
+                        t_rank);
+
+        if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          best_gains[s_t.first][s_t.second] = r.gain();
+          best_moves[s_t.first][s_t.second] =
+            Move{OPERATOR::REVERSE_TWO_OPT, s_rank, t_rank};
+        }
       }
     }
+  };
 
-    // 2-opt* stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.second <= s_t.first) {
-        // This operator is symmetric.
-        continue;
-      }
+  // Relocate stuff
+  auto try_relocate = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first == s_t.second or _sol[s_t.first].size() == 0) {
+      // Don't try to put things from an empty vehicle.
+      return;
+    }
 
-      // Determine first ranks for inner loops based on vehicles/jobs
-      // compatibility along the routes.
-      unsigned first_s_rank = 0;
-      const auto first_s_candidate =
-        _sol_state.bwd_skill_rank[s_t.first][s_t.second];
-      if (first_s_candidate > 0) {
-        first_s_rank = first_s_candidate - 1;
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
+      if (_sol_state.node_gains[s_t.first][s_rank] <=
+          best_gains[s_t.first][s_t.second]) {
+        // Except if addition cost in route s_t.second is negative
+        // (!!), overall gain can't exceed current known best gain.
+        continue;
       }
 
-      int first_t_rank = 0;
-      const auto first_t_candidate =
-        _sol_state.bwd_skill_rank[s_t.second][s_t.first];
-      if (first_t_candidate > 0) {
-        first_t_rank = first_t_candidate - 1;
+      const auto& s_job_rank = _sol[s_t.first].route[s_rank];
+      if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
+          !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
+        // Don't try moving (part of) a shipment or an
+        // incompatible job.
+        continue;
       }
 
-      for (unsigned s_rank = first_s_rank; s_rank < _sol[s_t.first].size();
-           ++s_rank) {
-        if (_sol[s_t.first].has_pending_delivery_after_rank(s_rank)) {
+      for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size(); ++t_rank) {
+        if (!creates_short_edge(s_t.second,
+                                t_rank,
+                                t_rank,
+                                s_job_rank,
+                                s_job_rank)) {
           continue;
         }
 
-        for (int t_rank = _sol[s_t.second].size() - 1; t_rank >= first_t_rank;
-             --t_rank) {
-          if (_sol[s_t.second].has_pending_delivery_after_rank(t_rank)) {
-            continue;
-          }
-
-          TwoOpt r(_input,
+        Relocate r(_input,
                    _sol_state,
                    _sol[s_t.first],
                    s_t.first,
@@ -686,526 +944,683 @@ void LocalSearch<Route,
                    s_t.second,
                    t_rank);
 
-          if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
-            best_gains[s_t.first][s_t.second] = r.gain();
-            best_ops[s_t.first][s_t.second] = std::make_unique<TwoOpt>(r);
-          }
+        if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          best_gains[s_t.first][s_t.second] = r.gain();
+          best_moves[s_t.first][s_t.second] =
+            Move{OPERATOR::RELOCATE, s_rank, t_rank};
         }
       }
     }
+  };
+
+  // Or-opt stuff
+  auto try_or_opt = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first == s_t.second or _sol[s_t.first].size() < 2) {
+      // Don't try to move things from a (near-)empty vehicle.
+      return;
+    }
 
-    // Reverse 2-opt* stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first == s_t.second) {
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
+      if (_sol_state.edge_gains[s_t.first][s_rank] <=
+          best_gains[s_t.first][s_t.second]) {
+        // Except if addition cost in route s_t.second is negative
+        // (!!), overall gain can't exceed current known best gain.
         continue;
       }
 
-      // Determine first rank for inner loop based on vehicles/jobs
-      // compatibility along the routes.
-      unsigned first_s_rank = 0;
-      const auto first_s_candidate =
-        _sol_state.bwd_skill_rank[s_t.first][s_t.second];
-      if (first_s_candidate > 0) {
-        first_s_rank = first_s_candidate - 1;
+      if (!_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_rank]) or
+          !_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_rank + 1])) {
+        continue;
       }
 
-      for (unsigned s_rank = first_s_rank; s_rank < _sol[s_t.first].size();
-           ++s_rank) {
-        if (_sol[s_t.first].has_delivery_after_rank(s_rank)) {
+      if (_input.jobs[_sol[s_t.first].route[s_rank]].type !=
+            JOB_TYPE::SINGLE or
+          _input.jobs[_sol[s_t.first].route[s_rank + 1]].type !=
+            JOB_TYPE::SINGLE) {
+        // Don't try moving part of a shipment. Moving a full
+        // shipment as an edge is not tested because it's a
+        // special case of PDShift.
+        continue;
+      }
+
+      for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size(); ++t_rank) {
+        if (!creates_short_edge(s_t.second,
+                                t_rank,
+                                t_rank,
+                                _sol[s_t.first].route[s_rank],
+                                _sol[s_t.first].route[s_rank + 1])) {
           continue;
         }
 
-        for (unsigned t_rank = 0;
-             t_rank < _sol_state.fwd_skill_rank[s_t.second][s_t.first];
-             ++t_rank) {
-          if (_sol[s_t.second].has_pickup_up_to_rank(t_rank)) {
-            continue;
-          }
-
-          ReverseTwoOpt r(_input,
-                          _sol_state,
-                          _sol[s_t.first],
-                          s_t.first,
-                          s_rank,
-                          _sol[s_t.second],
-                          s_t.second,
-                          t_rank);
-
-          if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
-            best_gains[s_t.first][s_t.second] = r.gain();
-            best_ops[s_t.first][s_t.second] =
-              std::make_unique<ReverseTwoOpt>(r);
-          }
+        OrOpt r(_input,
+                _sol_state,
+                _sol[s_t.first],
+                s_t.first,
+                s_rank,
+                _sol[s_t.second],
+                s_t.second,
+                t_rank);
+
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.second] =
+            Move{OPERATOR::OR_OPT, s_rank, t_rank};
         }
       }
     }
+  };
 
-    if (_input.has_jobs()) {
-      // Move(s) that don't make sense for shipment-only instances.
-
-      // Relocate stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or _sol[s_t.first].size() == 0) {
-          // Don't try to put things from an empty vehicle.
-          continue;
-        }
-
-        for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
-          if (_sol_state.node_gains[s_t.first][s_rank] <=
-              best_gains[s_t.first][s_t.second]) {
-            // Except if addition cost in route s_t.second is negative
-            // (!!), overall gain can't exceed current known best gain.
-            continue;
-          }
-
-          const auto& s_job_rank = _sol[s_t.first].route[s_rank];
-          if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
-              !_input.vehicle_ok_with_job(s_t.second, s_job_rank)) {
-            // Don't try moving (part of) a shipment or an
-            // incompatible job.
-            continue;
-          }
+  // Intra exchange stuff
+  auto try_intra_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first != s_t.second or _sol[s_t.first].size() < 3) {
+      return;
+    }
 
-          for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size();
-               ++t_rank) {
-            Relocate r(_input,
-                       _sol_state,
-                       _sol[s_t.first],
-                       s_t.first,
-                       s_rank,
-                       _sol[s_t.second],
-                       s_t.second,
-                       t_rank);
-
-            if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
-              best_gains[s_t.first][s_t.second] = r.gain();
-              best_ops[s_t.first][s_t.second] = std::make_unique<Relocate>(r);
-            }
-          }
-        }
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 2; ++s_rank) {
+      unsigned max_t_rank = _sol[s_t.first].size() - 1;
+      if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
+          JOB_TYPE::PICKUP) {
+        // Don't move a pickup past its matching delivery.
+        max_t_rank = _sol_state.matching_delivery_rank[s_t.first][s_rank] - 1;
       }
 
-      // Or-opt stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or _sol[s_t.first].size() < 2) {
-          // Don't try to move things from a (near-)empty vehicle.
+      for (unsigned t_rank = s_rank + 2; t_rank <= max_t_rank; ++t_rank) {
+        if (_input.jobs[_sol[s_t.first].route[t_rank]].type ==
+              JOB_TYPE::DELIVERY and
+            s_rank <= _sol_state.matching_pickup_rank[s_t.first][t_rank]) {
+          // Don't move a delivery before its matching pickup.
           continue;
         }
 
-        for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1;
-             ++s_rank) {
-          if (_sol_state.edge_gains[s_t.first][s_rank] <=
-              best_gains[s_t.first][s_t.second]) {
-            // Except if addition cost in route s_t.second is negative
-            // (!!), overall gain can't exceed current known best gain.
-            continue;
-          }
-
-          if (!_input.vehicle_ok_with_job(s_t.second,
-                                          _sol[s_t.first].route[s_rank]) or
-              !_input.vehicle_ok_with_job(s_t.second,
-                                          _sol[s_t.first].route[s_rank + 1])) {
-            continue;
-          }
-
-          if (_input.jobs[_sol[s_t.first].route[s_rank]].type !=
-                JOB_TYPE::SINGLE or
-              _input.jobs[_sol[s_t.first].route[s_rank + 1]].type !=
-                JOB_TYPE::SINGLE) {
-            // Don't try moving part of a shipment. Moving a full
-            // shipment as an edge is not tested because it's a
-            // special case of PDShift.
-            continue;
-          }
-
-          for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size();
-               ++t_rank) {
-            OrOpt r(_input,
-                    _sol_state,
-                    _sol[s_t.first],
-                    s_t.first,
-                    s_rank,
-                    _sol[s_t.second],
-                    s_t.second,
-                    t_rank);
-
-            auto& current_best = best_gains[s_t.first][s_t.second];
-            if (r.gain_upper_bound() > current_best and r.is_valid() and
-                r.gain() > current_best) {
-              current_best = r.gain();
-              best_ops[s_t.first][s_t.second] = std::make_unique<OrOpt>(r);
-            }
-          }
+        IntraExchange r(_input,
+                        _sol_state,
+                        _sol[s_t.first],
+                        s_t.first,
+                        s_rank,
+                        t_rank);
+
+        if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
+          best_gains[s_t.first][s_t.first] = r.gain();
+          best_moves[s_t.first][s_t.first] =
+            Move{OPERATOR::INTRA_EXCHANGE, s_rank, t_rank};
         }
       }
     }
+  };
 
-    // Operators applied to a single route.
+  // Intra CROSS-exchange stuff
+  auto try_intra_cross_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first != s_t.second or _sol[s_t.first].size() < 5) {
+      return;
+    }
+
+    for (unsigned s_rank = 0; s_rank <= _sol[s_t.first].size() - 4; ++s_rank) {
+      const auto& job_s_type =
+        _input.jobs[_sol[s_t.first].route[s_rank]].type;
+
+      bool both_s_single =
+        (job_s_type == JOB_TYPE::SINGLE) and
+        (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
+         JOB_TYPE::SINGLE);
 
-    // Intra exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or _sol[s_t.first].size() < 3) {
+      bool is_s_pickup =
+        (job_s_type == JOB_TYPE::PICKUP) and
+        (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
+
+      if (!both_s_single and !is_s_pickup) {
         continue;
       }
 
-      for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 2; ++s_rank) {
-        unsigned max_t_rank = _sol[s_t.first].size() - 1;
-        if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
-            JOB_TYPE::PICKUP) {
-          // Don't move a pickup past its matching delivery.
-          max_t_rank = _sol_state.matching_delivery_rank[s_t.first][s_rank] - 1;
-        }
+      for (unsigned t_rank = s_rank + 3; t_rank < _sol[s_t.first].size() - 1;
+           ++t_rank) {
+        const auto& job_t_type =
+          _input.jobs[_sol[s_t.second].route[t_rank]].type;
 
-        for (unsigned t_rank = s_rank + 2; t_rank <= max_t_rank; ++t_rank) {
-          if (_input.jobs[_sol[s_t.first].route[t_rank]].type ==
-                JOB_TYPE::DELIVERY and
-              s_rank <= _sol_state.matching_pickup_rank[s_t.first][t_rank]) {
-            // Don't move a delivery before its matching pickup.
-            continue;
-          }
+        bool both_t_single =
+          (job_t_type == JOB_TYPE::SINGLE) and
+          (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
+           JOB_TYPE::SINGLE);
 
-          IntraExchange r(_input,
-                          _sol_state,
-                          _sol[s_t.first],
-                          s_t.first,
-                          s_rank,
-                          t_rank);
+        bool is_t_pickup =
+          (job_t_type == JOB_TYPE::PICKUP) and
+          (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
+           t_rank + 1);
 
-          if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
-            best_gains[s_t.first][s_t.first] = r.gain();
-            best_ops[s_t.first][s_t.first] = std::make_unique<IntraExchange>(r);
-          }
+        if (!both_t_single and !is_t_pickup) {
+          continue;
+        }
+
+        IntraCrossExchange r(_input,
+                             _sol_state,
+                             _sol[s_t.first],
+                             s_t.first,
+                             s_rank,
+                             t_rank,
+                             !is_s_pickup,
+                             !is_t_pickup);
+
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.first] =
+            Move{OPERATOR::INTRA_CROSS_EXCHANGE,
+                 s_rank,
+                 t_rank,
+                 !is_s_pickup,
+                 !is_t_pickup};
         }
       }
     }
+  };
 
-    // Intra CROSS-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or _sol[s_t.first].size() < 5) {
+  // Intra mixed-exchange stuff
+  auto try_intra_mixed_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first != s_t.second or _sol[s_t.first].size() < 4) {
+      return;
+    }
+
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
+      if (_input.jobs[_sol[s_t.first].route[s_rank]].type !=
+          JOB_TYPE::SINGLE) {
+        // Don't try moving part of a shipment.
         continue;
       }
 
-      for (unsigned s_rank = 0; s_rank <= _sol[s_t.first].size() - 4;
-           ++s_rank) {
-        const auto& job_s_type =
-          _input.jobs[_sol[s_t.first].route[s_rank]].type;
+      for (unsigned t_rank = 0; t_rank < _sol[s_t.first].size() - 1; ++t_rank) {
+        if (t_rank <= s_rank + 1 and s_rank <= t_rank + 2) {
+          continue;
+        }
+        const auto& job_t_type =
+          _input.jobs[_sol[s_t.second].route[t_rank]].type;
 
-        bool both_s_single =
-          (job_s_type == JOB_TYPE::SINGLE) and
-          (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
+        bool both_t_single =
+          (job_t_type == JOB_TYPE::SINGLE) and
+          (_input.jobs[_sol[s_t.first].route[t_rank + 1]].type ==
            JOB_TYPE::SINGLE);
 
-        bool is_s_pickup =
-          (job_s_type == JOB_TYPE::PICKUP) and
-          (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
+        bool is_t_pickup =
+          (job_t_type == JOB_TYPE::PICKUP) and
+          (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
+           t_rank + 1);
 
-        if (!both_s_single and !is_s_pickup) {
+        if (!both_t_single and !is_t_pickup) {
           continue;
         }
 
-        for (unsigned t_rank = s_rank + 3; t_rank < _sol[s_t.first].size() - 1;
-             ++t_rank) {
-          const auto& job_t_type =
-            _input.jobs[_sol[s_t.second].route[t_rank]].type;
-
-          bool both_t_single =
-            (job_t_type == JOB_TYPE::SINGLE) and
-            (_input.jobs[_sol[s_t.second].route[t_rank + 1]].type ==
-             JOB_TYPE::SINGLE);
-
-          bool is_t_pickup =
-            (job_t_type == JOB_TYPE::PICKUP) and
-            (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
-             t_rank + 1);
-
-          if (!both_t_single and !is_t_pickup) {
-            continue;
-          }
-
-          IntraCrossExchange r(_input,
-                               _sol_state,
-                               _sol[s_t.first],
-                               s_t.first,
-                               s_rank,
-                               t_rank,
-                               !is_s_pickup,
-                               !is_t_pickup);
-
-          auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
-              r.gain() > current_best) {
-            current_best = r.gain();
-            best_ops[s_t.first][s_t.first] =
-              std::make_unique<IntraCrossExchange>(r);
-          }
+        IntraMixedExchange r(_input,
+                             _sol_state,
+                             _sol[s_t.first],
+                             s_t.first,
+                             s_rank,
+                             t_rank,
+                             !is_t_pickup);
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.first] =
+            Move{OPERATOR::INTRA_MIXED_EXCHANGE,
+                 s_rank,
+                 t_rank,
+                 false,
+                 !is_t_pickup};
         }
       }
     }
+  };
+
+  // Intra relocate stuff
+  auto try_intra_relocate = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first != s_t.second or _sol[s_t.first].size() < 2) {
+      return;
+    }
 
-    // Intra mixed-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or _sol[s_t.first].size() < 4) {
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
+      if (_sol_state.node_gains[s_t.first][s_rank] <=
+          best_gains[s_t.first][s_t.first]) {
+        // Except if addition cost in route is negative (!!),
+        // overall gain can't exceed current known best gain.
         continue;
       }
 
-      for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
-        if (_input.jobs[_sol[s_t.first].route[s_rank]].type !=
-            JOB_TYPE::SINGLE) {
-          // Don't try moving part of a shipment.
-          continue;
-        }
-
-        for (unsigned t_rank = 0; t_rank < _sol[s_t.first].size() - 1;
-             ++t_rank) {
-          if (t_rank <= s_rank + 1 and s_rank <= t_rank + 2) {
-            continue;
-          }
-          const auto& job_t_type =
-            _input.jobs[_sol[s_t.second].route[t_rank]].type;
-
-          bool both_t_single =
-            (job_t_type == JOB_TYPE::SINGLE) and
-            (_input.jobs[_sol[s_t.first].route[t_rank + 1]].type ==
-             JOB_TYPE::SINGLE);
+      unsigned min_t_rank = 0;
+      if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
+          JOB_TYPE::DELIVERY) {
+        // Don't move a delivery before its matching pickup.
+        min_t_rank = _sol_state.matching_pickup_rank[s_t.first][s_rank] + 1;
+      }
 
-          bool is_t_pickup =
-            (job_t_type == JOB_TYPE::PICKUP) and
-            (_sol_state.matching_delivery_rank[s_t.second][t_rank] ==
-             t_rank + 1);
+      unsigned max_t_rank = _sol[s_t.first].size() - 1;
+      if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
+          JOB_TYPE::PICKUP) {
+        // Don't move a pickup past its matching delivery.
+        max_t_rank = _sol_state.matching_delivery_rank[s_t.first][s_rank] - 1;
+      }
 
-          if (!both_t_single and !is_t_pickup) {
-            continue;
-          }
+      for (unsigned t_rank = min_t_rank; t_rank <= max_t_rank; ++t_rank) {
+        if (t_rank == s_rank) {
+          continue;
+        }
 
-          IntraMixedExchange r(_input,
-                               _sol_state,
-                               _sol[s_t.first],
-                               s_t.first,
-                               s_rank,
-                               t_rank,
-                               !is_t_pickup);
-          auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
-              r.gain() > current_best) {
-            current_best = r.gain();
-            best_ops[s_t.first][s_t.first] =
-              std::make_unique<IntraMixedExchange>(r);
-          }
+        IntraRelocate r(_input,
+                        _sol_state,
+                        _sol[s_t.first],
+                        s_t.first,
+                        s_rank,
+                        t_rank);
+
+        if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
+          best_gains[s_t.first][s_t.first] = r.gain();
+          best_moves[s_t.first][s_t.first] =
+            Move{OPERATOR::INTRA_RELOCATE, s_rank, t_rank};
         }
       }
     }
+  };
+
+  // Intra Or-opt stuff
+  auto try_intra_or_opt = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first != s_t.second or _sol[s_t.first].size() < 4) {
+      return;
+    }
+    for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
+      const auto& job_type = _input.jobs[_sol[s_t.first].route[s_rank]].type;
+
+      bool both_single =
+        (job_type == JOB_TYPE::SINGLE) and
+        (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
+         JOB_TYPE::SINGLE);
+
+      bool is_pickup =
+        (job_type == JOB_TYPE::PICKUP) and
+        (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
 
-    // Intra relocate stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or _sol[s_t.first].size() < 2) {
+      if (!both_single and !is_pickup) {
         continue;
       }
 
-      for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
-        if (_sol_state.node_gains[s_t.first][s_rank] <=
+      if (is_pickup) {
+        if (_sol_state.pd_gains[s_t.first][s_rank] <=
             best_gains[s_t.first][s_t.first]) {
           // Except if addition cost in route is negative (!!),
           // overall gain can't exceed current known best gain.
           continue;
         }
-
-        unsigned min_t_rank = 0;
-        if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
-            JOB_TYPE::DELIVERY) {
-          // Don't move a delivery before its matching pickup.
-          min_t_rank = _sol_state.matching_pickup_rank[s_t.first][s_rank] + 1;
+      } else {
+        // Regular single job.
+        if (_sol_state.edge_gains[s_t.first][s_rank] <=
+            best_gains[s_t.first][s_t.first]) {
+          // Except if addition cost in route is negative (!!),
+          // overall gain can't exceed current known best gain.
+          continue;
         }
+      }
 
-        unsigned max_t_rank = _sol[s_t.first].size() - 1;
-        if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
-            JOB_TYPE::PICKUP) {
-          // Don't move a pickup past its matching delivery.
-          max_t_rank = _sol_state.matching_delivery_rank[s_t.first][s_rank] - 1;
+      for (unsigned t_rank = 0; t_rank <= _sol[s_t.first].size() - 2;
+           ++t_rank) {
+        if (t_rank == s_rank) {
+          continue;
+        }
+        IntraOrOpt r(_input,
+                     _sol_state,
+                     _sol[s_t.first],
+                     s_t.first,
+                     s_rank,
+                     t_rank,
+                     !is_pickup);
+        auto& current_best = best_gains[s_t.first][s_t.second];
+        if (r.gain_upper_bound() > current_best and r.is_valid() and
+            r.gain() > current_best) {
+          current_best = r.gain();
+          best_moves[s_t.first][s_t.first] =
+            Move{OPERATOR::INTRA_OR_OPT, s_rank, t_rank, !is_pickup};
         }
+      }
+    }
+  };
 
-        for (unsigned t_rank = min_t_rank; t_rank <= max_t_rank; ++t_rank) {
-          if (t_rank == s_rank) {
-            continue;
-          }
+  // P&D relocate stuff
+  auto try_pd_shift = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.first == s_t.second or _sol[s_t.first].size() == 0) {
+      // Don't try to put things from an empty vehicle.
+      return;
+    }
 
-          IntraRelocate r(_input,
-                          _sol_state,
-                          _sol[s_t.first],
-                          s_t.first,
-                          s_rank,
-                          t_rank);
+    for (unsigned s_p_rank = 0; s_p_rank < _sol[s_t.first].size(); ++s_p_rank) {
+      if (_input.jobs[_sol[s_t.first].route[s_p_rank]].type !=
+          JOB_TYPE::PICKUP) {
+        continue;
+      }
 
-          if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
-            best_gains[s_t.first][s_t.first] = r.gain();
-            best_ops[s_t.first][s_t.first] = std::make_unique<IntraRelocate>(r);
-          }
-        }
+      // Matching delivery rank in source route.
+      unsigned s_d_rank =
+        _sol_state.matching_delivery_rank[s_t.first][s_p_rank];
+
+      if (!_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_p_rank]) or
+          !_input.vehicle_ok_with_job(s_t.second,
+                                      _sol[s_t.first].route[s_d_rank])) {
+        continue;
       }
-    }
 
-    // Intra Or-opt stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or _sol[s_t.first].size() < 4) {
+      if (_sol_state.pd_gains[s_t.first][s_p_rank] <=
+          best_gains[s_t.first][s_t.second]) {
+        // Except if addition cost in route s_t.second is negative
+        // (!!), overall gain can't exceed current known best gain.
         continue;
       }
-      for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
-        const auto& job_type = _input.jobs[_sol[s_t.first].route[s_rank]].type;
 
-        bool both_single =
-          (job_type == JOB_TYPE::SINGLE) and
-          (_input.jobs[_sol[s_t.first].route[s_rank + 1]].type ==
-           JOB_TYPE::SINGLE);
+      PDShift pdr(_input,
+                  _sol_state,
+                  _sol[s_t.first],
+                  s_t.first,
+                  s_p_rank,
+                  s_d_rank,
+                  _sol[s_t.second],
+                  s_t.second,
+                  best_gains[s_t.first][s_t.second]);
+
+      if (pdr.gain() > best_gains[s_t.first][s_t.second] and
+          pdr.is_valid()) {
+        // Store gain threshold used upon building operator.
+        best_moves[s_t.first][s_t.second] =
+          Move{OPERATOR::PD_SHIFT,
+               s_p_rank,
+               0,
+               false,
+               false,
+               s_d_rank,
+               best_gains[s_t.first][s_t.second]};
+        best_gains[s_t.first][s_t.second] = pdr.gain();
+      }
+    }
+  };
+
+  // Route exchange stuff
+  auto try_route_exchange = [&](const std::pair<Index, Index>& s_t) {
+    if (s_t.second <= s_t.first or
+        (_sol[s_t.first].size() == 0 and _sol[s_t.second].size() == 0) or
+        _sol_state.bwd_skill_rank[s_t.first][s_t.second] > 0 or
+        _sol_state.bwd_skill_rank[s_t.second][s_t.first] > 0) {
+      // Different routes (and operator is symmetric), at least
+      // one non-empty and valid wrt vehicle/job compatibility.
+      return;
+    }
 
-        bool is_pickup =
-          (job_type == JOB_TYPE::PICKUP) and
-          (_sol_state.matching_delivery_rank[s_t.first][s_rank] == s_rank + 1);
+    RouteExchange re(_input,
+                     _sol_state,
+                     _sol[s_t.first],
+                     s_t.first,
+                     _sol[s_t.second],
+                     s_t.second);
 
-        if (!both_single and !is_pickup) {
-          continue;
-        }
+    if (re.gain() > best_gains[s_t.first][s_t.second] and re.is_valid()) {
+      best_gains[s_t.first][s_t.second] = re.gain();
+      best_moves[s_t.first][s_t.second] = Move{OPERATOR::ROUTE_EXCHANGE};
+    }
+  };
 
-        if (is_pickup) {
-          if (_sol_state.pd_gains[s_t.first][s_rank] <=
-              best_gains[s_t.first][s_t.first]) {
-            // Except if addition cost in route is negative (!!),
-            // overall gain can't exceed current known best gain.
-            continue;
-          }
-        } else {
-          // Regular single job.
-          if (_sol_state.edge_gains[s_t.first][s_rank] <=
-              best_gains[s_t.first][s_t.first]) {
-            // Except if addition cost in route is negative (!!),
-            // overall gain can't exceed current known best gain.
-            continue;
-          }
-        }
+  // Evaluate all operators for a given source/target pair. Each
+  // move only updates best_gains and best_moves for its own pair, so
+  // distinct pairs can be evaluated concurrently.
+  auto evaluate_pair = [&](const std::pair<Index, Index>& s_t) {
+    // Operators applied to a pair of (different) routes.
 
-        for (unsigned t_rank = 0; t_rank <= _sol[s_t.first].size() - 2;
-             ++t_rank) {
-          if (t_rank == s_rank) {
-            continue;
-          }
-          IntraOrOpt r(_input,
-                       _sol_state,
-                       _sol[s_t.first],
-                       s_t.first,
-                       s_rank,
-                       t_rank,
-                       !is_pickup);
-          auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
-              r.gain() > current_best) {
-            current_best = r.gain();
-            best_ops[s_t.first][s_t.first] = std::make_unique<IntraOrOpt>(r);
-          }
-        }
-      }
+    if (_input.has_jobs()) {
+      // Move(s) that don't make sense for shipment-only instances.
+      try_exchange(s_t);
     }
 
+    try_cross_exchange(s_t);
+
+    if (_input.has_jobs()) {
+      try_mixed_exchange(s_t);
+    }
+
+    try_two_opt(s_t);
+    try_reverse_two_opt(s_t);
+
+    if (_input.has_jobs()) {
+      // Move(s) that don't make sense for shipment-only instances.
+      try_relocate(s_t);
+      try_or_opt(s_t);
+    }
+
+    // Operators applied to a single route.
+    try_intra_exchange(s_t);
+    try_intra_cross_exchange(s_t);
+    try_intra_mixed_exchange(s_t);
+    try_intra_relocate(s_t);
+    try_intra_or_opt(s_t);
+
     if (_input.has_shipments()) {
       // Move(s) that don't make sense for job-only instances.
+      try_pd_shift(s_t);
+    }
 
-      // P&D relocate stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or _sol[s_t.first].size() == 0) {
-          // Don't try to put things from an empty vehicle.
-          continue;
-        }
-
-        for (unsigned s_p_rank = 0; s_p_rank < _sol[s_t.first].size();
-             ++s_p_rank) {
-          if (_input.jobs[_sol[s_t.first].route[s_p_rank]].type !=
-              JOB_TYPE::PICKUP) {
-            continue;
-          }
+    if (!_input.has_homogeneous_locations()) {
+      try_route_exchange(s_t);
+    }
+  };
+
+  // Operators are applied after replaying the calls made upon
+  // evaluation so that internal choices (e.g. reversing edges) are
+  // the same. Return update and addition candidates.
+  auto apply_op = [&](auto& op, [[maybe_unused]] Gain gain) {
+    [[maybe_unused]] const Gain replayed_gain = op.gain();
+    [[maybe_unused]] const bool valid = op.is_valid();
+    assert(valid and replayed_gain == gain);
+
+    op.apply();
+    return std::make_pair(op.update_candidates(), op.addition_candidates());
+  };
+
+  auto apply_bounded_op = [&](auto& op, [[maybe_unused]] Gain gain) {
+    op.gain_upper_bound();
+    [[maybe_unused]] const bool valid = op.is_valid();
+    [[maybe_unused]] const Gain replayed_gain = op.gain();
+    assert(valid and replayed_gain == gain);
+
+    op.apply();
+    return std::make_pair(op.update_candidates(), op.addition_candidates());
+  };
+
+  // Rebuild and apply best move for given source/target pair.
+  auto apply_move = [&](Index s_v, Index t_v) {
+    const auto& m = best_moves[s_v][t_v];
+    const auto gain = best_gains[s_v][t_v];
+    auto& s_route = _sol[s_v];
+    auto& t_route = _sol[t_v];
+
+    switch (m.op) {
+    case OPERATOR::EXCHANGE: {
+      Exchange
+        op(_input, _sol_state, s_route, s_v, m.s_rank, t_route, t_v, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::CROSS_EXCHANGE: {
+      CrossExchange op(_input,
+                       _sol_state,
+                       s_route,
+                       s_v,
+                       m.s_rank,
+                       t_route,
+                       t_v,
+                       m.t_rank,
+                       m.check_s_reverse,
+                       m.check_t_reverse);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::MIXED_EXCHANGE: {
+      MixedExchange op(_input,
+                       _sol_state,
+                       s_route,
+                       s_v,
+                       m.s_rank,
+                       t_route,
+                       t_v,
+                       m.t_rank,
+                       m.check_t_reverse);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::TWO_OPT: {
+      TwoOpt
+        op(_input, _sol_state, s_route, s_v, m.s_rank, t_route, t_v, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::REVERSE_TWO_OPT: {
+      ReverseTwoOpt
+        op(_input, _sol_state, s_route, s_v, m.s_rank, t_route, t_v, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::RELOCATE: {
+      Relocate
+        op(_input, _sol_state, s_route, s_v, m.s_rank, t_route, t_v, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::OR_OPT: {
+      OrOpt
+        op(_input, _sol_state, s_route, s_v, m.s_rank, t_route, t_v, m.t_rank);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::INTRA_EXCHANGE: {
+      IntraExchange op(_input, _sol_state, s_route, s_v, m.s_rank, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::INTRA_CROSS_EXCHANGE: {
+      IntraCrossExchange op(_input,
+                            _sol_state,
+                            s_route,
+                            s_v,
+                            m.s_rank,
+                            m.t_rank,
+                            m.check_s_reverse,
+                            m.check_t_reverse);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::INTRA_MIXED_EXCHANGE: {
+      IntraMixedExchange op(_input,
+                            _sol_state,
+                            s_route,
+                            s_v,
+                            m.s_rank,
+                            m.t_rank,
+                            m.check_t_reverse);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::INTRA_RELOCATE: {
+      IntraRelocate op(_input, _sol_state, s_route, s_v, m.s_rank, m.t_rank);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::INTRA_OR_OPT: {
+      IntraOrOpt op(_input,
+                    _sol_state,
+                    s_route,
+                    s_v,
+                    m.s_rank,
+                    m.t_rank,
+                    m.check_s_reverse);
+      return apply_bounded_op(op, gain);
+    }
+    case OPERATOR::PD_SHIFT: {
+      PDShift op(_input,
+                 _sol_state,
+                 s_route,
+                 s_v,
+                 m.s_rank,
+                 m.s_d_rank,
+                 t_route,
+                 t_v,
+                 m.gain_threshold);
+      return apply_op(op, gain);
+    }
+    case OPERATOR::ROUTE_EXCHANGE: {
+      RouteExchange op(_input, _sol_state, s_route, s_v, t_route, t_v);
+      return apply_op(op, gain);
+    }
+    }
 
-          // Matching delivery rank in source route.
-          unsigned s_d_rank =
-            _sol_state.matching_delivery_rank[s_t.first][s_p_rank];
+    assert(false);
+    return std::make_pair(std::vector<Index>(), std::vector<Index>());
+  };
+
+  // Max-heap of (gain, source, target) for pairs with a positive
+  // best gain. Entries are pushed each time a pair is evaluated and
+  // outdated ones are only discarded when reaching the top. Ties are
+  // broken on lowest source then target rank.
+  using PairGain = std::tuple<Gain, Index, Index>;
+  auto lower_priority = [](const PairGain& lhs, const PairGain& rhs) {
+    if (std::get<0>(lhs) != std::get<0>(rhs)) {
+      return std::get<0>(lhs) < std::get<0>(rhs);
+    }
+    return std::make_pair(std::get<1>(lhs), std::get<2>(lhs)) >
+           std::make_pair(std::get<1>(rhs), std::get<2>(rhs));
+  };
+  std::vector<PairGain> best_pairs;
 
-          if (!_input.vehicle_ok_with_job(s_t.second,
-                                          _sol[s_t.first].route[s_p_rank]) or
-              !_input.vehicle_ok_with_job(s_t.second,
-                                          _sol[s_t.first].route[s_d_rank])) {
-            continue;
-          }
+  Gain best_gain = 1;
 
-          if (_sol_state.pd_gains[s_t.first][s_p_rank] <=
-              best_gains[s_t.first][s_t.second]) {
-            // Except if addition cost in route s_t.second is negative
-            // (!!), overall gain can't exceed current known best gain.
-            continue;
-          }
+  while (best_gain > 0) {
+    if (utils::deadline_reached(_deadline)) {
+      // Keep current solution, all applied moves so far are valid.
+      break;
+    }
 
-          PDShift pdr(_input,
-                      _sol_state,
-                      _sol[s_t.first],
-                      s_t.first,
-                      s_p_rank,
-                      s_d_rank,
-                      _sol[s_t.second],
-                      s_t.second,
-                      best_gains[s_t.first][s_t.second]);
-
-          if (pdr.gain() > best_gains[s_t.first][s_t.second] and
-              pdr.is_valid()) {
-            best_gains[s_t.first][s_t.second] = pdr.gain();
-            best_ops[s_t.first][s_t.second] = std::make_unique<PDShift>(pdr);
+    // Pairs are handed out one at a time to pool workers to balance
+    // uneven workloads.
+    utils::ThreadPool::shared().parallel_for(s_t_pairs.size(),
+                                             _nb_threads,
+                                             [&](std::size_t i) {
+                                               evaluate_pair(s_t_pairs[i]);
+                                             });
+
+    if (best_pairs.size() > 2 * _nb_vehicles * _nb_vehicles) {
+      // Too many outdated entries, rebuild from current gains.
+      best_pairs.clear();
+      for (Index s_v = 0; s_v < _nb_vehicles; ++s_v) {
+        for (Index t_v = 0; t_v < _nb_vehicles; ++t_v) {
+          if (best_gains[s_v][t_v] > 0) {
+            best_pairs.emplace_back(best_gains[s_v][t_v], s_v, t_v);
           }
         }
       }
-    }
-
-    if (!_input.has_homogeneous_locations()) {
-      // Route exchange stuff
+      std::make_heap(best_pairs.begin(), best_pairs.end(), lower_priority);
+    } else {
       for (const auto& s_t : s_t_pairs) {
-        if (s_t.second <= s_t.first or
-            (_sol[s_t.first].size() == 0 and _sol[s_t.second].size() == 0) or
-            _sol_state.bwd_skill_rank[s_t.first][s_t.second] > 0 or
-            _sol_state.bwd_skill_rank[s_t.second][s_t.first] > 0) {
-          // Different routes (and operator is symmetric), at least
-          // one non-empty and valid wrt vehicle/job compatibility.
-          continue;
-        }
-
-        RouteExchange re(_input,
-                         _sol_state,
-                         _sol[s_t.first],
-                         s_t.first,
-                         _sol[s_t.second],
-                         s_t.second);
-
-        if (re.gain() > best_gains[s_t.first][s_t.second] and re.is_valid()) {
-          best_gains[s_t.first][s_t.second] = re.gain();
-          best_ops[s_t.first][s_t.second] = std::make_unique<RouteExchange>(re);
+        const auto gain = best_gains[s_t.first][s_t.second];
+        if (gain > 0) {
+          best_pairs.emplace_back(gain, s_t.first, s_t.second);
+          std::push_heap(best_pairs.begin(), best_pairs.end(), lower_priority);
         }
       }
     }
 
-    // Find best overall gain.
+    // Find best overall gain, discarding outdated entries.
     best_gain = 0;
     Index best_source = 0;
     Index best_target = 0;
 
-    for (unsigned s_v = 0; s_v < _nb_vehicles; ++s_v) {
-      for (unsigned t_v = 0; t_v < _nb_vehicles; ++t_v) {
-        if (best_gains[s_v][t_v] > best_gain) {
-          best_gain = best_gains[s_v][t_v];
-          best_source = s_v;
-          best_target = t_v;
-        }
+    while (!best_pairs.empty()) {
+      const auto [gain, s_v, t_v] = best_pairs.front();
+      if (gain == best_gains[s_v][t_v]) {
+        best_gain = gain;
+        best_source = s_v;
+        best_target = t_v;
+        break;
       }
+      std::pop_heap(best_pairs.begin(), best_pairs.end(), lower_priority);
+      best_pairs.pop_back();
     }
 
     // Apply matching operator.
     if (best_gain > 0) {
-      assert(best_ops[best_source][best_target] != nullptr);
-
-      best_ops[best_source][best_target]->apply();
-
-      auto update_candidates =
-        best_ops[best_source][best_target]->update_candidates();
+      const auto [update_candidates, addition_candidates] =
+        apply_move(best_source, best_target);
 
 #ifndef NDEBUG
       // Update route costs.
@@ -1228,25 +1643,12 @@ void LocalSearch<Route,
       assert(new_cost + best_gain == previous_cost);
 #endif
 
-      try_job_additions(best_ops[best_source][best_target]
-                          ->addition_candidates(),
-                        0);
+      try_job_additions(addition_candidates, 0);
 
-      // Running update_costs only after try_job_additions is fine.
+      // Running update only after try_job_additions is fine, values
+      // are only recomputed around modified ranges.
       for (auto v_rank : update_candidates) {
-        _sol_state.update_costs(_sol[v_rank].route, v_rank);
-      }
-
-      for (auto v_rank : update_candidates) {
-        _sol_state.update_skills(_sol[v_rank].route, v_rank);
-      }
-
-      // Update candidates.
-      for (auto v_rank : update_candidates) {
-        _sol_state.set_node_gains(_sol[v_rank].route, v_rank);
-        _sol_state.set_edge_gains(_sol[v_rank].route, v_rank);
-        _sol_state.set_pd_matching_ranks(_sol[v_rank].route, v_rank);
-        _sol_state.set_pd_gains(_sol[v_rank].route, v_rank);
+        update_state(v_rank);
       }
 
       // Set gains to zero for what needs to be recomputed in the next
@@ -1267,10 +1669,59 @@ void LocalSearch<Route,
           }
         }
       }
+
+      // Avoid evaluating the same pair several times (and
+      // concurrently) when several routes have been updated.
+      std::sort(s_t_pairs.begin(), s_t_pairs.end());
+      s_t_pairs.erase(std::unique(s_t_pairs.begin(), s_t_pairs.end()),
+                      s_t_pairs.end());
     }
   }
 }
 
+template <class Route,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::update_state(Index v) {
+  const auto range = _sol[v].pop_modified_range();
+  if (!range.has_value()) {
+    return;
+  }
+
+  _sol_state.update(_sol[v].route,
+                    v,
+                    range->first_rank,
+                    range->old_last_rank,
+                    range->new_last_rank);
+  _modified_since_best[v] = true;
+}
+
 template <class Route,
           class Exchange,
           class CrossExchange,
@@ -1341,38 +1792,60 @@ void LocalSearch<Route,
 
     if (current_sol_indicators < _best_sol_indicators) {
       _best_sol_indicators = current_sol_indicators;
-      _best_sol = _sol;
+      for (std::size_t v = 0; v < _sol.size(); ++v) {
+        if (_modified_since_best[v]) {
+          _best_sol[v] = _sol[v];
+          _modified_since_best[v] = false;
+        }
+      }
+      _best_unassigned = _sol_state.unassigned;
+      if (_incumbent != nullptr) {
+        _incumbent->update(_best_sol_indicators);
+      }
     } else {
       if (!first_step) {
         ++current_nb_removal;
       }
       if (_best_sol_indicators < current_sol_indicators) {
         // Back to best known solution for further steps.
-        _sol = _best_sol;
-        _sol_state.setup(_sol);
+        for (std::size_t v = 0; v < _sol.size(); ++v) {
+          if (_modified_since_best[v]) {
+            _sol[v] = _best_sol[v];
+            _sol[v].pop_modified_range();
+            _sol_state.setup(_sol[v].route, v);
+            _modified_since_best[v] = false;
+          }
+        }
+        _sol_state.unassigned = _best_unassigned;
       }
     }
 
     // Try again on each improvement until we reach last job removal
     // level.
-    try_ls_step = (current_nb_removal <= _max_nb_jobs_removal);
+    try_ls_step = (current_nb_removal <= _max_nb_jobs_removal) and
+                  !utils::deadline_reached(_deadline);
+
+    if (first_step and try_ls_step and is_dominated(_best_sol_indicators)) {
+      // Leave remaining time to more promising seeds.
+      try_ls_step = false;
+    }
 
     if (try_ls_step) {
       // Get a looser situation by removing jobs.
       for (unsigned i = 0; i < current_nb_removal; ++i) {
         remove_from_routes();
         for (std::size_t v = 0; v < _sol.size(); ++v) {
-          _sol_state.set_node_gains(_sol[v].route, v);
-          _sol_state.set_pd_matching_ranks(_sol[v].route, v);
-          _sol_state.set_pd_gains(_sol[v].route, v);
+          update_state(v);
         }
       }
 
       // Refill jobs.
       try_job_additions(_all_routes, 1.5);
 
-      // Reset what is needed in solution state.
-      _sol_state.setup(_sol);
+      // Update solution state for modified routes.
+      for (std::size_t v = 0; v < _sol.size(); ++v) {
+        update_state(v);
+      }
     }
 
     first_step = false;
@@ -1428,14 +1901,22 @@ Gain LocalSearch<Route,
   }
   if (_sol[v_target].size() != 0) {
     auto nearest_from_rank =
-      _sol_state.nearest_job_rank_in_routes_from[v][v_target][r];
+      _sol_state.nearest_job_rank_in_route_from(v,
+                                                v_target,
+                                                _sol[v].route,
+                                                _sol[v_target].route,
+                                                r);
     auto nearest_from_index =
       _input.jobs[_sol[v_target].route[nearest_from_rank]].index();
     Gain cost_from = _matrix[nearest_from_index][job_index];
     cost = std::min(cost, cost_from);
 
     auto nearest_to_rank =
-      _sol_state.nearest_job_rank_in_routes_to[v][v_target][r];
+      _sol_state.nearest_job_rank_in_route_to(v,
+                                              v_target,
+                                              _sol[v].route,
+                                              _sol[v_target].route,
+                                              r);
     auto nearest_to_index =
       _input.jobs[_sol[v_target].route[nearest_to_rank]].index();
     Gain Costo = _matrix[job_index][nearest_to_index];
@@ -1567,20 +2048,6 @@ void LocalSearch<Route,
                  IntraOrOpt,
                  PDShift,
                  RouteExchange>::remove_from_routes() {
-  // Store nearest job from and to any job in any route for constant
-  // time access down the line.
-  for (std::size_t v1 = 0; v1 < _nb_vehicles; ++v1) {
-    for (std::size_t v2 = 0; v2 < _nb_vehicles; ++v2) {
-      if (v2 == v1) {
-        continue;
-      }
-      _sol_state.update_nearest_job_rank_in_routes(_sol[v1].route,
-                                                   _sol[v2].route,
-                                                   v1,
-                                                   v2);
-    }
-  }
-
   // Remove best node candidate from all routes.
   std::vector<std::pair<Index, Index>> routes_and_ranks;
 
@@ -1673,6 +2140,51 @@ void LocalSearch<Route,
   }
 }
 
+template <class Route,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+bool LocalSearch<Route,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::is_dominated(
+  const utils::SolutionIndicators& indicators) const {
+  if (_incumbent == nullptr) {
+    return false;
+  }
+  const auto incumbent = _incumbent->get();
+  if (!incumbent.has_value()) {
+    return false;
+  }
+
+  const auto& best = incumbent.value();
+  return indicators.priority_sum <= best.priority_sum and
+         indicators.unassigned >= best.unassigned and
+         indicators.cost > (1 + MAX_INCUMBENT_COST_GAP) * best.cost;
+}
+
 template <class Route,
           class Exchange,
           class CrossExchange,
@@ -17,6 +17,38 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace ls {
 
+enum class OPERATOR {
+  EXCHANGE,
+  CROSS_EXCHANGE,
+  MIXED_EXCHANGE,
+  TWO_OPT,
+  REVERSE_TWO_OPT,
+  RELOCATE,
+  OR_OPT,
+  INTRA_EXCHANGE,
+  INTRA_CROSS_EXCHANGE,
+  INTRA_MIXED_EXCHANGE,
+  INTRA_RELOCATE,
+  INTRA_OR_OPT,
+  PD_SHIFT,
+  ROUTE_EXCHANGE
+};
+
+// Compact description of a candidate move between two routes, with
+// enough data to rebuild the matching operator when applying it.
+struct Move {
+  OPERATOR op{OPERATOR::EXCHANGE};
+  unsigned s_rank{0};
+  unsigned t_rank{0};
+  // Reverse checks for (intra) CROSS-exchange, mixed-exchange and
+  // intra or-opt.
+  bool check_s_reverse{false};
+  bool check_t_reverse{false};
+  // Delivery rank and gain threshold for P&D shift.
+  unsigned s_d_rank{0};
+  Gain gain_threshold{0};
+};
+
 template <class Route,
           class Exchange,
           class CrossExchange,
@@ -39,6 +71,9 @@ private:
   const std::size_t _nb_vehicles;
 
   const unsigned _max_nb_jobs_removal;
+  const unsigned _nb_threads;
+  const Deadline _deadline;
+  utils::SharedIndicators* const _incumbent;
   std::vector<Index> _all_routes;
 
   utils::SolutionState _sol_state;
@@ -46,15 +81,34 @@ private:
   std::vector<Route> _sol;
 
   std::vector<Route>& _best_sol;
+  // Whether route v has been modified since _best_sol was stored.
+  std::vector<bool> _modified_since_best;
+  std::unordered_set<Index> _best_unassigned;
   utils::SolutionIndicators _best_sol_indicators;
 
   void try_job_additions(const std::vector<Index>& routes, double regret_coeff);
 
   void run_ls_step();
 
+  // Update solution state around modified range in route v, if any.
+  void update_state(Index v);
+
+  // Granular neighbourhood filter: returns true if replacing ranks
+  // [first_rank, last_rank) in route v with a sequence of jobs
+  // starting with job rank first_job and ending with job rank
+  // last_job (in any direction) creates at least one short edge with
+  // a neighbouring job in route v. Always true if granular
+  // neighbourhoods are disabled or if no edge between jobs is
+  // created.
+  bool creates_short_edge(Index v,
+                          Index first_rank,
+                          Index last_rank,
+                          Index first_job,
+                          Index last_job) const;
+
   // Compute "cost" between route at rank v_target and job with rank r
-  // in route at rank v. Relies on
-  // _sol_state.nearest_job_rank_in_routes_* being up to date.
+  // in route at rank v. Relies on _sol_state being up to date for
+  // both routes.
   Gain job_route_cost(Index v_target, Index v, Index r);
 
   // Compute best cost of relocating job at rank r (resp. jobs at rank
@@ -64,10 +118,17 @@ private:
 
   void remove_from_routes();
 
+  // Whether current solution is so far behind incumbent that further
+  // improvement is not worth it.
+  bool is_dominated(const utils::SolutionIndicators& indicators) const;
+
 public:
   LocalSearch(const Input& input,
               std::vector<Route>& tw_sol,
-              unsigned max_nb_jobs_removal);
+              unsigned max_nb_jobs_removal,
+              unsigned nb_threads = 1,
+              const Deadline& deadline = Deadline(),
+              utils::SharedIndicators* incumbent = nullptr);
 
   utils::SolutionIndicators indicators() const;
 
@@ -18,7 +18,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace ls {
 
-class Operator {
+// Base class for concrete operators, Derived being the class
+// providing compute_gain. Operators are only ever used with their
+// exact type from LocalSearch template code, so there is no virtual
+// member.
+template <class Derived> class Operator {
 protected:
   const Input& _input;
   const utils::SolutionState& _sol_state;
@@ -37,8 +41,6 @@ protected:
   bool gain_computed;
   Gain stored_gain;
 
-  virtual void compute_gain() = 0;
-
 public:
   Operator(const Input& input,
            const utils::SolutionState& sol_state,
@@ -62,18 +64,20 @@ public:
       stored_gain(0) {
   }
 
-  virtual Gain gain();
-
-  virtual bool is_valid() = 0;
-
-  virtual void apply() = 0;
-
-  virtual std::vector<Index> addition_candidates() const = 0;
-
-  virtual std::vector<Index> update_candidates() const = 0;
-
-  virtual ~Operator() {
+  Gain gain() {
+    if (!gain_computed) {
+      static_cast<Derived*>(this)->compute_gain();
+    }
+    return stored_gain;
   }
+
+  // Concrete operators also provide the following members:
+  //
+  // void compute_gain();
+  // bool is_valid();
+  // void apply();
+  // std::vector<Index> addition_candidates() const;
+  // std::vector<Index> update_candidates() const;
 };
 
 } // namespace ls
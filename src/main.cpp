@@ -10,6 +10,7 @@ All rights reserved (see LICENSE).
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <unistd.h>
 
 #if USE_LIBOSRM
@@ -24,6 +25,7 @@ All rights reserved (see LICENSE).
 #include "utils/helpers.h"
 #include "utils/input_parser.h"
 #include "utils/output_json.h"
+#include "utils/thread_pool.h"
 #include "utils/version.h"
 
 void display_usage() {
@@ -34,12 +36,21 @@ void display_usage() {
   usage += "Options:\n";
   usage += "\t-a PROFILE:HOST (=" + vroom::DEFAULT_PROFILE +
            ":0.0.0.0)\t routing server\n";
+  usage += "\t-c DIR,\t\t\t\t cache routing durations in DIR\n";
+  usage += "\t-d,\t\t\t\t add route distances from routing matrix\n";
   usage += "\t-g,\t\t\t\t add detailed route geometry and indicators\n";
   usage += "\t-i FILE,\t\t\t read input from FILE rather than from stdin\n";
+  usage += "\t-k NEIGHBOURS (=0),\t\t nearest jobs used in local search "
+           "(0 for all)\n";
+  usage += "\t-l LIMIT,\t\t\t stop solving process after LIMIT seconds\n";
+  usage += "\t-m SIZE (=0),\t\t\t split routing matrix requests in "
+           "SIZE x SIZE tiles (0 for no split)\n";
   usage += "\t-o OUTPUT,\t\t\t output file name\n";
   usage += "\t-p PROFILE:PORT (=" + vroom::DEFAULT_PROFILE +
            ":5000),\t routing server port\n";
   usage += "\t-r ROUTER (=osrm),\t\t osrm, libosrm or ors\n";
+  usage += "\t-s,\t\t\t\t stop local search early for seeds far behind "
+           "other threads (nondeterministic)\n";
   usage += "\t-t THREADS (=4),\t\t number of threads to use\n";
   usage += "\t-x EXPLORE (=5),\t\t exploration level to use (0..5)";
   std::cout << usage << std::endl;
@@ -51,10 +62,13 @@ int main(int argc, char** argv) {
   vroom::io::CLArgs cl_args;
 
   // Parsing command-line arguments.
-  const char* optString = "a:e:gi:o:p:r:t:x:h?";
+  const char* optString = "a:c:de:gi:k:l:m:o:p:r:st:x:h?";
   int opt = getopt(argc, argv, optString);
 
   std::string router_arg;
+  std::string nb_neighbours_arg = std::to_string(cl_args.nb_neighbours);
+  std::string limit_arg;
+  std::string matrix_tile_size_arg = std::to_string(cl_args.matrix_tile_size);
   std::string nb_threads_arg = std::to_string(cl_args.nb_threads);
   std::string exploration_level_arg = std::to_string(cl_args.exploration_level);
   std::vector<std::string> heuristic_params_arg;
@@ -64,6 +78,12 @@ int main(int argc, char** argv) {
     case 'a':
       vroom::io::update_host(cl_args.servers, optarg);
       break;
+    case 'c':
+      cl_args.matrix_cache_dir = optarg;
+      break;
+    case 'd':
+      cl_args.distances = true;
+      break;
     case 'e':
       heuristic_params_arg.push_back(optarg);
       break;
@@ -76,6 +96,15 @@ int main(int argc, char** argv) {
     case 'i':
       cl_args.input_file = optarg;
       break;
+    case 'k':
+      nb_neighbours_arg = optarg;
+      break;
+    case 'l':
+      limit_arg = optarg;
+      break;
+    case 'm':
+      matrix_tile_size_arg = optarg;
+      break;
     case 'o':
       cl_args.output_file = optarg;
       break;
@@ -85,6 +114,9 @@ int main(int argc, char** argv) {
     case 'r':
       router_arg = optarg;
       break;
+    case 's':
+      cl_args.seed_pruning = true;
+      break;
     case 't':
       nb_threads_arg = optarg;
       break;
@@ -100,16 +132,31 @@ int main(int argc, char** argv) {
   try {
     // Needs to be done after previous switch to make sure the
     // appropriate output file is set.
+    cl_args.nb_neighbours = std::stoul(nb_neighbours_arg);
     cl_args.nb_threads = std::stoul(nb_threads_arg);
+    cl_args.matrix_tile_size = std::stoul(matrix_tile_size_arg);
     cl_args.exploration_level = std::stoul(exploration_level_arg);
 
     cl_args.exploration_level =
       std::min(cl_args.exploration_level, cl_args.max_exploration_level);
+
+    if (!limit_arg.empty()) {
+      // Internally timeout is in milliseconds.
+      auto limit = std::stod(limit_arg);
+      if (limit < 0) {
+        throw std::invalid_argument("Negative time limit.");
+      }
+      cl_args.timeout = std::chrono::milliseconds(
+        static_cast<std::chrono::milliseconds::rep>(1000 * limit));
+    }
   } catch (const std::exception& e) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::INPUT);
     std::string message = "Invalid numerical value in option.";
     std::cerr << "[Error] " << message << std::endl;
-    vroom::io::write_to_json({error_code, message}, false, cl_args.output_file);
+    vroom::io::write_to_json({error_code, message},
+                             false,
+                             false,
+                             cl_args.output_file);
     exit(error_code);
   }
 
@@ -122,7 +169,10 @@ int main(int argc, char** argv) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::INPUT);
     std::string message = "Invalid routing engine: " + router_arg + ".";
     std::cerr << "[Error] " << message << std::endl;
-    vroom::io::write_to_json({error_code, message}, false, cl_args.output_file);
+    vroom::io::write_to_json({error_code, message},
+                             false,
+                             false,
+                             cl_args.output_file);
     exit(error_code);
   }
 
@@ -139,6 +189,7 @@ int main(int argc, char** argv) {
     auto error_code = vroom::utils::get_code(e.error);
     std::cerr << "[Error] " << e.message << std::endl;
     vroom::io::write_to_json({error_code, e.message},
+                             false,
                              false,
                              cl_args.output_file);
     exit(error_code);
@@ -164,20 +215,30 @@ int main(int argc, char** argv) {
     cl_args.input = buffer.str();
   }
 
+  // The calling thread takes part in all parallel work, so -t is the
+  // total number of threads used.
+  vroom::utils::ThreadPool::set_shared_max_workers(
+    std::max(cl_args.nb_threads, 1u) - 1);
+
   try {
     // Build problem.
     vroom::Input problem_instance = vroom::io::parse(cl_args);
 
     vroom::Solution sol = problem_instance.solve(cl_args.exploration_level,
                                                  cl_args.nb_threads,
-                                                 cl_args.h_params);
+                                                 cl_args.h_params,
+                                                 cl_args.timeout);
 
     // Write solution.
-    vroom::io::write_to_json(sol, cl_args.geometry, cl_args.output_file);
+    vroom::io::write_to_json(sol,
+                             cl_args.geometry,
+                             cl_args.geometry or cl_args.distances,
+                             cl_args.output_file);
   } catch (const vroom::Exception& e) {
     auto error_code = vroom::utils::get_code(e.error);
     std::cerr << "[Error] " << e.message << std::endl;
     vroom::io::write_to_json({error_code, e.message},
+                             false,
                              false,
                              cl_args.output_file);
     exit(error_code);
@@ -188,7 +249,10 @@ int main(int argc, char** argv) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::ROUTING);
     auto message = "Routing problem: " + std::string(e.what());
     std::cerr << "[Error] " << message << std::endl;
-    vroom::io::write_to_json({error_code, message}, false, cl_args.output_file);
+    vroom::io::write_to_json({error_code, message},
+                             false,
+                             false,
+                             cl_args.output_file);
     exit(error_code);
   }
 #endif
@@ -197,6 +261,7 @@ int main(int argc, char** argv) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::INTERNAL);
     std::cerr << "[Error] " << e.what() << std::endl;
     vroom::io::write_to_json({error_code, e.what()},
+                             false,
                              false,
                              cl_args.output_file);
     exit(error_code);
@@ -8,7 +8,6 @@ All rights reserved (see LICENSE).
 */
 
 #include <numeric>
-#include <thread>
 
 #include "algorithms/heuristics/solomon.h"
 #include "algorithms/local_search/local_search.h"
@@ -31,6 +30,7 @@ All rights reserved (see LICENSE).
 #include "structures/vroom/input/input.h"
 #include "structures/vroom/raw_route.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 
@@ -139,6 +139,7 @@ CVRP::CVRP(const Input& input) : VRP(input) {
 
 Solution CVRP::solve(unsigned exploration_level,
                      unsigned nb_threads,
+                     const Deadline& deadline,
                      const std::vector<HeuristicParameters>& h_param) const {
   if (_input.vehicles.size() == 1 and !_input.has_skills() and
       _input.zero_amount().size() == 0 and !_input.has_shipments()) {
@@ -149,7 +150,7 @@ Solution CVRP::solve(unsigned exploration_level,
     TSP p(_input, job_ranks, 0);
 
     RawRoute r(_input, 0);
-    r.set_route(_input, p.raw_solve(nb_threads));
+    r.set_route(_input, p.raw_solve(nb_threads, deadline));
 
     return utils::format_solution(_input, {r});
   }
@@ -178,56 +179,66 @@ Solution CVRP::solve(unsigned exploration_level,
 
   std::vector<RawSolution> solutions(nb_init_solutions);
   std::vector<utils::SolutionIndicators> sol_indicators(nb_init_solutions);
-
-  // Split the work among threads.
-  std::vector<std::vector<std::size_t>>
-    thread_ranks(nb_threads, std::vector<std::size_t>());
-  for (std::size_t i = 0; i < nb_init_solutions; ++i) {
-    thread_ranks[i % nb_threads].push_back(i);
-  }
-
-  auto run_solve = [&](const std::vector<std::size_t>& param_ranks) {
-    for (auto rank : param_ranks) {
-      auto& p = parameters[rank];
-
-      switch (p.heuristic) {
-      case HEURISTIC::BASIC:
-        solutions[rank] =
-          heuristics::basic<RawSolution>(_input, p.init, p.regret_coeff);
-        break;
-      case HEURISTIC::DYNAMIC:
-        solutions[rank] =
-          heuristics::dynamic_vehicle_choice<RawSolution>(_input,
-                                                          p.init,
-                                                          p.regret_coeff);
-        break;
-      }
-
-      // Local search phase.
-      LocalSearch ls(_input, solutions[rank], max_nb_jobs_removal);
-      ls.run();
-
-      // Store solution indicators.
-      sol_indicators[rank] = ls.indicators();
+  std::vector<unsigned char> solved(nb_init_solutions, false);
+  utils::SharedIndicators incumbent;
+
+  // Split the work among threads. Threads left over when there are
+  // less solutions to compute than available threads are used to
+  // parallelize the local search for each solution.
+  unsigned nb_ls_threads = std::max(1u, nb_threads / nb_init_solutions);
+  nb_threads = std::min(nb_threads, nb_init_solutions);
+
+  auto run_solve = [&](std::size_t rank) {
+    if (rank > 0 and utils::deadline_reached(deadline)) {
+      // Out of time, only make sure that at least one solution is
+      // computed.
+      return;
     }
-  };
 
-  std::vector<std::thread> solving_threads;
+    auto& p = parameters[rank];
+
+    switch (p.heuristic) {
+    case HEURISTIC::BASIC:
+      solutions[rank] =
+        heuristics::basic<RawSolution>(_input, p.init, p.regret_coeff);
+      break;
+    case HEURISTIC::DYNAMIC:
+      solutions[rank] =
+        heuristics::dynamic_vehicle_choice<RawSolution>(_input,
+                                                        p.init,
+                                                        p.regret_coeff);
+      break;
+    }
 
-  for (std::size_t i = 0; i < nb_threads; ++i) {
-    solving_threads.emplace_back(run_solve, thread_ranks[i]);
-  }
+    // Local search phase.
+    LocalSearch ls(_input,
+                   solutions[rank],
+                   max_nb_jobs_removal,
+                   nb_ls_threads,
+                   deadline,
+                   _input.has_seed_pruning() ? &incumbent : nullptr);
+    ls.run();
+
+    // Store solution indicators.
+    sol_indicators[rank] = ls.indicators();
+    solved[rank] = true;
+  };
 
-  for (auto& t : solving_threads) {
-    t.join();
+  // Ranks are handed out one at a time as threads get available, so
+  // that uneven solving times are balanced across threads.
+  utils::ThreadPool::shared().parallel_for(nb_init_solutions,
+                                           nb_threads,
+                                           run_solve);
+
+  // Pick best solution among those computed before deadline.
+  std::size_t best_rank = 0;
+  for (std::size_t rank = 1; rank < nb_init_solutions; ++rank) {
+    if (solved[rank] and sol_indicators[rank] < sol_indicators[best_rank]) {
+      best_rank = rank;
+    }
   }
 
-  auto best_indic =
-    std::min_element(sol_indicators.cbegin(), sol_indicators.cend());
-
-  return utils::format_solution(_input,
-                                solutions[std::distance(sol_indicators.cbegin(),
-                                                        best_indic)]);
+  return utils::format_solution(_input, solutions[best_rank]);
 }
 
 } // namespace vroom
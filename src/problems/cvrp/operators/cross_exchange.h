@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class CrossExchange : public ls::Operator {
+class CrossExchange : public ls::Operator<CrossExchange> {
 private:
   bool _gain_upper_bound_computed;
   Gain _normal_s_gain;
@@ -34,7 +34,9 @@ protected:
   bool t_is_normal_valid;
   bool t_is_reverse_valid;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<CrossExchange>;
+
+  void compute_gain();
 
 public:
   CrossExchange(const Input& input,
@@ -53,13 +55,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
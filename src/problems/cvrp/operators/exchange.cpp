@@ -136,8 +136,8 @@ bool Exchange::is_valid() {
 void Exchange::apply() {
   std::swap(s_route[s_rank], t_route[t_rank]);
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank, s_rank + 1, s_rank + 1);
+  target.update_amounts(_input, t_rank, t_rank + 1, t_rank + 1);
 }
 
 std::vector<Index> Exchange::addition_candidates() const {
@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "problems/cvrp/operators/intra_cross_exchange.h"
 #include "utils/helpers.h"
 
@@ -290,7 +292,9 @@ void IntraCrossExchange::apply() {
     std::swap(s_route[s_rank], s_route[s_rank + 1]);
   }
 
-  source.update_amounts(_input);
+  const Index first_rank = std::min(s_rank, t_rank);
+  const Index last_rank = std::max(s_rank, t_rank) + 2;
+  source.update_amounts(_input, first_rank, last_rank, last_rank);
 }
 
 std::vector<Index> IntraCrossExchange::addition_candidates() const {
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class IntraCrossExchange : public ls::Operator {
+class IntraCrossExchange : public ls::Operator<IntraCrossExchange> {
 private:
   bool _gain_upper_bound_computed;
   Gain _normal_s_gain;
@@ -38,7 +38,9 @@ protected:
   const Index _first_rank;
   const Index _last_rank;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<IntraCrossExchange>;
+
+  void compute_gain();
 
 public:
   IntraCrossExchange(const Input& input,
@@ -55,13 +57,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
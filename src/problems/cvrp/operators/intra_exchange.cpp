@@ -114,7 +114,7 @@ bool IntraExchange::is_valid() {
 void IntraExchange::apply() {
   std::swap(s_route[s_rank], t_route[t_rank]);
 
-  source.update_amounts(_input);
+  source.update_amounts(_input, s_rank, t_rank + 1, t_rank + 1);
 }
 
 std::vector<Index> IntraExchange::addition_candidates() const {
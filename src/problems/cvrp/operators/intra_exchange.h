@@ -15,13 +15,15 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class IntraExchange : public ls::Operator {
+class IntraExchange : public ls::Operator<IntraExchange> {
 protected:
   std::vector<Index> _moved_jobs;
   const Index _first_rank;
   const Index _last_rank;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<IntraExchange>;
+
+  void compute_gain();
 
 public:
   IntraExchange(const Input& input,
@@ -31,13 +33,13 @@ public:
                 Index s_rank,
                 Index t_rank);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "problems/cvrp/operators/intra_mixed_exchange.h"
 #include "utils/helpers.h"
 
@@ -249,7 +251,9 @@ void IntraMixedExchange::apply() {
 
   s_route.insert(s_route.begin() + end_t_rank, t_after);
 
-  source.update_amounts(_input);
+  const Index first_rank = std::min(s_rank, t_rank);
+  const Index last_rank = std::max(s_rank + 1, t_rank + 2);
+  source.update_amounts(_input, first_rank, last_rank, last_rank);
 }
 
 std::vector<Index> IntraMixedExchange::addition_candidates() const {
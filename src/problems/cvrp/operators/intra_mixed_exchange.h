@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class IntraMixedExchange : public ls::Operator {
+class IntraMixedExchange : public ls::Operator<IntraMixedExchange> {
 private:
   bool _gain_upper_bound_computed;
   Gain _normal_s_gain;
@@ -35,7 +35,9 @@ protected:
   Index _t_edge_first;
   Index _t_edge_last;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<IntraMixedExchange>;
+
+  void compute_gain();
 
 public:
   IntraMixedExchange(const Input& input,
@@ -51,13 +53,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
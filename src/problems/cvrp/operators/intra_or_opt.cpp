@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "problems/cvrp/operators/intra_or_opt.h"
 #include "utils/helpers.h"
 
@@ -217,7 +219,9 @@ void IntraOrOpt::apply() {
     std::swap(t_route[t_rank], t_route[t_rank + 1]);
   }
 
-  source.update_amounts(_input);
+  const Index first_rank = std::min(s_rank, t_rank);
+  const Index last_rank = std::max(s_rank, t_rank) + 2;
+  source.update_amounts(_input, first_rank, last_rank, last_rank);
 }
 
 std::vector<Index> IntraOrOpt::addition_candidates() const {
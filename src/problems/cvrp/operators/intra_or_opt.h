@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class IntraOrOpt : public ls::Operator {
+class IntraOrOpt : public ls::Operator<IntraOrOpt> {
 private:
   bool _gain_upper_bound_computed;
   Gain _s_gain;
@@ -35,7 +35,9 @@ protected:
   Index _s_edge_first;
   Index _s_edge_last;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<IntraOrOpt>;
+
+  void compute_gain();
 
 public:
   IntraOrOpt(const Input& input,
@@ -51,13 +53,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
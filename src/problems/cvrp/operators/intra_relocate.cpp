@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "problems/cvrp/operators/intra_relocate.h"
 #include "utils/helpers.h"
 
@@ -89,7 +91,9 @@ void IntraRelocate::apply() {
   s_route.erase(s_route.begin() + s_rank);
   s_route.insert(t_route.begin() + t_rank, relocate_job_rank);
 
-  source.update_amounts(_input);
+  const Index first_rank = std::min(s_rank, t_rank);
+  const Index last_rank = std::max(s_rank, t_rank) + 1;
+  source.update_amounts(_input, first_rank, last_rank, last_rank);
 }
 
 std::vector<Index> IntraRelocate::addition_candidates() const {
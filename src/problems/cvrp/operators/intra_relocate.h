@@ -15,9 +15,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class IntraRelocate : public ls::Operator {
+class IntraRelocate : public ls::Operator<IntraRelocate> {
 protected:
-  virtual void compute_gain() override;
+  friend class ls::Operator<IntraRelocate>;
+
+  void compute_gain();
 
   std::vector<Index> _moved_jobs;
   const Index _first_rank;
@@ -31,13 +33,13 @@ public:
                 Index s_rank,
                 Index t_rank); // relocate rank *after* removal.
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
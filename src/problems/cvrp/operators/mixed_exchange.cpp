@@ -243,8 +243,8 @@ void MixedExchange::apply() {
     std::swap(s_route[s_rank], s_route[s_rank + 1]);
   }
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank, s_rank + 1, s_rank + 2);
+  target.update_amounts(_input, t_rank, t_rank + 2, t_rank + 1);
 }
 
 std::vector<Index> MixedExchange::addition_candidates() const {
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class MixedExchange : public ls::Operator {
+class MixedExchange : public ls::Operator<MixedExchange> {
 private:
   bool _gain_upper_bound_computed;
   Gain _normal_s_gain;
@@ -29,7 +29,9 @@ protected:
   bool s_is_normal_valid;
   bool s_is_reverse_valid;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<MixedExchange>;
+
+  void compute_gain();
 
 public:
   MixedExchange(const Input& input,
@@ -47,13 +49,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
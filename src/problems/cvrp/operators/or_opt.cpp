@@ -198,8 +198,8 @@ void OrOpt::apply() {
 
   s_route.erase(s_route.begin() + s_rank, s_route.begin() + s_rank + 2);
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank, s_rank + 2, s_rank);
+  target.update_amounts(_input, t_rank, t_rank, t_rank + 2);
 }
 
 std::vector<Index> OrOpt::addition_candidates() const {
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class OrOpt : public ls::Operator {
+class OrOpt : public ls::Operator<OrOpt> {
 private:
   bool _gain_upper_bound_computed;
   Gain _s_gain;
@@ -27,7 +27,9 @@ protected:
   bool is_normal_valid;
   bool is_reverse_valid;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<OrOpt>;
+
+  void compute_gain();
 
 public:
   OrOpt(const Input& input,
@@ -44,13 +46,13 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
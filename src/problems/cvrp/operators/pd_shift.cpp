@@ -144,7 +144,7 @@ void PDShift::apply() {
 
   if (_s_d_rank == _s_p_rank + 1) {
     s_route.erase(s_route.begin() + _s_p_rank, s_route.begin() + _s_p_rank + 2);
-    source.update_amounts(_input);
+    source.update_amounts(_input, _s_p_rank, _s_p_rank + 2, _s_p_rank);
   } else {
     std::vector<Index> source_without_pd(s_route.begin() + _s_p_rank + 1,
                                          s_route.begin() + _s_d_rank);
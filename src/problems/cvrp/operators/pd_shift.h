@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class PDShift : public ls::Operator {
+class PDShift : public ls::Operator<PDShift> {
 protected:
   const Index _s_p_rank;
   const Index _s_d_rank;
@@ -24,7 +24,9 @@ protected:
   Index _best_t_d_rank;
   bool _valid;
 
-  virtual void compute_gain() override;
+  friend class ls::Operator<PDShift>;
+
+  void compute_gain();
 
 public:
   // The gain_threshold parameter serves as a filter to NOT even test
@@ -40,13 +42,13 @@ public:
           Index t_vehicle,
           Gain gain_threshold);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
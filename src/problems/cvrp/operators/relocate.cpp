@@ -67,8 +67,8 @@ void Relocate::apply() {
   s_route.erase(s_route.begin() + s_rank);
   t_route.insert(t_route.begin() + t_rank, relocate_job_rank);
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank, s_rank + 1, s_rank);
+  target.update_amounts(_input, t_rank, t_rank, t_rank + 1);
 }
 
 std::vector<Index> Relocate::addition_candidates() const {
@@ -15,9 +15,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class Relocate : public ls::Operator {
+class Relocate : public ls::Operator<Relocate> {
 protected:
-  virtual void compute_gain() override;
+  friend class ls::Operator<Relocate>;
+
+  void compute_gain();
 
 public:
   Relocate(const Input& input,
@@ -29,13 +31,13 @@ public:
            Index t_vehicle,
            Index t_rank);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
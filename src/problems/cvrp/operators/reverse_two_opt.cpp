@@ -172,6 +172,7 @@ bool ReverseTwoOpt::is_valid() {
 }
 
 void ReverseTwoOpt::apply() {
+  const Index old_s_size = s_route.size();
   auto nb_source = s_route.size() - 1 - s_rank;
 
   t_route.insert(t_route.begin(),
@@ -184,8 +185,8 @@ void ReverseTwoOpt::apply() {
   t_route.erase(t_route.begin() + nb_source,
                 t_route.begin() + nb_source + t_rank + 1);
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank + 1, old_s_size, s_route.size());
+  target.update_amounts(_input, 0, t_rank + 1, nb_source);
 }
 
 std::vector<Index> ReverseTwoOpt::addition_candidates() const {
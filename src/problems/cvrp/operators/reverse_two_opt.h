@@ -15,9 +15,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class ReverseTwoOpt : public ls::Operator {
+class ReverseTwoOpt : public ls::Operator<ReverseTwoOpt> {
 protected:
-  virtual void compute_gain() override;
+  friend class ls::Operator<ReverseTwoOpt>;
+
+  void compute_gain();
 
 public:
   ReverseTwoOpt(const Input& input,
@@ -29,13 +31,13 @@ public:
                 Index t_vehicle,
                 Index t_rank);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
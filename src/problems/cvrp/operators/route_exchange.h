@@ -15,9 +15,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace cvrp {
 
-class RouteExchange : public ls::Operator {
+class RouteExchange : public ls::Operator<RouteExchange> {
 protected:
-  virtual void compute_gain() override;
+  friend class ls::Operator<RouteExchange>;
+
+  void compute_gain();
 
 public:
   RouteExchange(const Input& input,
@@ -27,13 +29,13 @@ public:
                 RawRoute& t_route,
                 Index t_vehicle);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 
-  virtual std::vector<Index> update_candidates() const override;
+  std::vector<Index> update_candidates() const;
 };
 
 } // namespace cvrp
@@ -130,6 +130,8 @@ bool TwoOpt::is_valid() {
 }
 
 void TwoOpt::apply() {
+  const Index old_s_size = s_route.size();
+  const Index old_t_size = t_route.size();
   auto nb_source = s_route.size() - 1 - s_rank;
 
   t_route.insert(t_route.begin() + t_rank + 1,
@@ -141,8 +143,8 @@ void TwoOpt::apply() {
                  t_route.end());
   t_route.erase(t_route.begin() + t_rank + 1 + nb_source, t_route.end());
 
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.update_amounts(_input, s_rank + 1, old_s_size, s_route.size());
+  target.update_amounts(_input, t_rank + 1, old_t_size, t_route.size());
 }
 
 std::vector<Index> TwoOpt::addition_candidates() const {
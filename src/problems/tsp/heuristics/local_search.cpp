@@ -9,10 +9,10 @@ All rights reserved (see LICENSE).
 
 #include <algorithm>
 #include <numeric>
-#include <thread>
 #include <unordered_map>
 
 #include "problems/tsp/heuristics/local_search.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 namespace tsp {
@@ -167,27 +167,18 @@ Cost LocalSearch::relocate_step() {
   std::vector<Index> best_edge_1_starts(_nb_threads);
   std::vector<Index> best_edge_2_starts(_nb_threads);
 
-  // Start other threads, keeping a piece of the range for the main
+  // Split the look-up ranges among pool workers and the calling
   // thread.
-  std::vector<std::thread> threads;
-  for (std::size_t i = 0; i < _nb_threads - 1; ++i) {
-    threads.emplace_back(look_up,
-                         _rank_limits[i],
-                         _rank_limits[i + 1],
-                         std::ref(best_gains[i]),
-                         std::ref(best_edge_1_starts[i]),
-                         std::ref(best_edge_2_starts[i]));
-  }
-
-  look_up(_rank_limits[_nb_threads - 1],
-          _rank_limits[_nb_threads],
-          std::ref(best_gains[_nb_threads - 1]),
-          std::ref(best_edge_1_starts[_nb_threads - 1]),
-          std::ref(best_edge_2_starts[_nb_threads - 1]));
-
-  for (auto& t : threads) {
-    t.join();
-  }
+  auto run_look_up = [&](std::size_t i) {
+    look_up(_rank_limits[i],
+            _rank_limits[i + 1],
+            best_gains[i],
+            best_edge_1_starts[i],
+            best_edge_2_starts[i]);
+  };
+  utils::ThreadPool::shared().parallel_for(_nb_threads,
+                                           _nb_threads,
+                                           run_look_up);
 
   // Spot best gain found among all threads.
   auto best_rank =
@@ -432,27 +423,18 @@ Cost LocalSearch::two_opt_step() {
   std::vector<Index> best_edge_1_starts(_nb_threads);
   std::vector<Index> best_edge_2_starts(_nb_threads);
 
-  // Start other threads, keeping a piece of the range for the main
+  // Split the look-up ranges among pool workers and the calling
   // thread.
-  std::vector<std::thread> threads;
-  for (std::size_t i = 0; i < _nb_threads - 1; ++i) {
-    threads.emplace_back(look_up,
-                         _sym_two_opt_rank_limits[i],
-                         _sym_two_opt_rank_limits[i + 1],
-                         std::ref(best_gains[i]),
-                         std::ref(best_edge_1_starts[i]),
-                         std::ref(best_edge_2_starts[i]));
-  }
-
-  look_up(_sym_two_opt_rank_limits[_nb_threads - 1],
-          _sym_two_opt_rank_limits[_nb_threads],
-          std::ref(best_gains[_nb_threads - 1]),
-          std::ref(best_edge_1_starts[_nb_threads - 1]),
-          std::ref(best_edge_2_starts[_nb_threads - 1]));
-
-  for (auto& t : threads) {
-    t.join();
-  }
+  auto run_look_up = [&](std::size_t i) {
+    look_up(_sym_two_opt_rank_limits[i],
+            _sym_two_opt_rank_limits[i + 1],
+            best_gains[i],
+            best_edge_1_starts[i],
+            best_edge_2_starts[i]);
+  };
+  utils::ThreadPool::shared().parallel_for(_nb_threads,
+                                           _nb_threads,
+                                           run_look_up);
 
   // Spot best gain found among all threads.
   auto best_rank =
@@ -572,27 +554,18 @@ Cost LocalSearch::asym_two_opt_step() {
   }
   limit_nodes.push_back(init);
 
-  // Start other threads, keeping a piece of the range for the main
+  // Split the look-up ranges among pool workers and the calling
   // thread.
-  std::vector<std::thread> threads;
-  for (std::size_t i = 0; i < _nb_threads - 1; ++i) {
-    threads.emplace_back(look_up,
-                         limit_nodes[i],
-                         limit_nodes[i + 1],
-                         std::ref(best_gains[i]),
-                         std::ref(best_edge_1_starts[i]),
-                         std::ref(best_edge_2_starts[i]));
-  }
-
-  look_up(limit_nodes[_nb_threads - 1],
-          limit_nodes[_nb_threads],
-          std::ref(best_gains[_nb_threads - 1]),
-          std::ref(best_edge_1_starts[_nb_threads - 1]),
-          std::ref(best_edge_2_starts[_nb_threads - 1]));
-
-  for (auto& t : threads) {
-    t.join();
-  }
+  auto run_look_up = [&](std::size_t i) {
+    look_up(limit_nodes[i],
+            limit_nodes[i + 1],
+            best_gains[i],
+            best_edge_1_starts[i],
+            best_edge_2_starts[i]);
+  };
+  utils::ThreadPool::shared().parallel_for(_nb_threads,
+                                           _nb_threads,
+                                           run_look_up);
 
   // Spot best gain found among all threads.
   auto best_rank =
@@ -713,27 +686,18 @@ Cost LocalSearch::or_opt_step() {
   std::vector<Index> best_edge_1_starts(_nb_threads);
   std::vector<Index> best_edge_2_starts(_nb_threads);
 
-  // Start other threads, keeping a piece of the range for the main
+  // Split the look-up ranges among pool workers and the calling
   // thread.
-  std::vector<std::thread> threads;
-  for (std::size_t i = 0; i < _nb_threads - 1; ++i) {
-    threads.emplace_back(look_up,
-                         _rank_limits[i],
-                         _rank_limits[i + 1],
-                         std::ref(best_gains[i]),
-                         std::ref(best_edge_1_starts[i]),
-                         std::ref(best_edge_2_starts[i]));
-  }
-
-  look_up(_rank_limits[_nb_threads - 1],
-          _rank_limits[_nb_threads],
-          std::ref(best_gains[_nb_threads - 1]),
-          std::ref(best_edge_1_starts[_nb_threads - 1]),
-          std::ref(best_edge_2_starts[_nb_threads - 1]));
-
-  for (auto& t : threads) {
-    t.join();
-  }
+  auto run_look_up = [&](std::size_t i) {
+    look_up(_rank_limits[i],
+            _rank_limits[i + 1],
+            best_gains[i],
+            best_edge_1_starts[i],
+            best_edge_2_starts[i]);
+  };
+  utils::ThreadPool::shared().parallel_for(_nb_threads,
+                                           _nb_threads,
+                                           run_look_up);
 
   // Spot best gain found among all threads.
   auto best_rank =
@@ -159,7 +159,8 @@ Cost TSP::symmetrized_cost(const std::list<Index>& tour) const {
   return cost;
 }
 
-std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
+std::vector<Index> TSP::raw_solve(unsigned nb_threads,
+                                  const Deadline& deadline) const {
   // Applying heuristic.
   std::list<Index> christo_sol = tsp::christofides(_symmetrized_matrix);
 
@@ -188,8 +189,9 @@ std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
 
     // All or-opt moves.
     sym_or_opt_gain = sym_ls.perform_all_or_opt_steps();
-  } while ((sym_two_opt_gain > 0) or (sym_relocate_gain > 0) or
-           (sym_or_opt_gain > 0));
+  } while (((sym_two_opt_gain > 0) or (sym_relocate_gain > 0) or
+            (sym_or_opt_gain > 0)) and
+           !utils::deadline_reached(deadline));
 
   Index first_loc_index;
   if (_has_start) {
@@ -235,8 +237,9 @@ std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
 
       // All or-opt moves.
       asym_or_opt_gain = asym_ls.perform_all_or_opt_steps();
-    } while ((asym_two_opt_gain > 0) or (asym_relocate_gain > 0) or
-             (asym_or_opt_gain > 0) or (asym_avoid_loops_gain > 0));
+    } while (((asym_two_opt_gain > 0) or (asym_relocate_gain > 0) or
+              (asym_or_opt_gain > 0) or (asym_avoid_loops_gain > 0)) and
+             !utils::deadline_reached(deadline));
 
     current_sol = asym_ls.get_tour(first_loc_index);
   }
@@ -272,9 +275,10 @@ std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
 
 Solution TSP::solve(unsigned,
                     unsigned nb_threads,
+                    const Deadline& deadline,
                     const std::vector<HeuristicParameters>&) const {
   RawRoute r(_input, 0);
-  r.set_route(_input, raw_solve(nb_threads));
+  r.set_route(_input, raw_solve(nb_threads, deadline));
   return utils::format_solution(_input, {r});
 }
 
@@ -33,9 +33,9 @@ public:
                 bool check_s_reverse,
                 bool check_t_reverse);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 };
 
 } // namespace vrptw
@@ -30,11 +30,11 @@ public:
                      bool check_s_reverse,
                      bool check_t_reverse);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 };
 
 } // namespace vrptw
@@ -28,11 +28,11 @@ public:
                 Index s_rank,
                 Index t_rank);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 };
 
 } // namespace vrptw
@@ -29,11 +29,11 @@ public:
                      Index t_rank,
                      bool check_t_reverse);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 
-  virtual std::vector<Index> addition_candidates() const override;
+  std::vector<Index> addition_candidates() const;
 };
 
 } // namespace vrptw
@@ -32,9 +32,9 @@ public:
                 Index t_rank,
                 bool check_t_reverse);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 };
 
 } // namespace vrptw
@@ -23,7 +23,7 @@ private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
 
-  virtual void compute_gain() override;
+  void compute_gain();
 
 public:
   PDShift(const Input& input,
@@ -36,9 +36,18 @@ public:
           Index t_vehicle,
           Gain gain_threshold);
 
+  // Hides gain from base operator, which relies on
+  // cvrp::PDShift::compute_gain.
+  Gain gain() {
+    if (!gain_computed) {
+      compute_gain();
+    }
+    return stored_gain;
+  }
+
   void log_route(const std::vector<Index>& route) const;
 
-  virtual void apply() override;
+  void apply();
 };
 
 } // namespace vrptw
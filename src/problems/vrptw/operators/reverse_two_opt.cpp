@@ -37,12 +37,18 @@ ReverseTwoOpt::ReverseTwoOpt(const Input& input,
 bool ReverseTwoOpt::is_valid() {
   return cvrp::ReverseTwoOpt::is_valid() and
          _tw_t_route.is_valid_addition_for_tw(_input,
+                                              _tw_s_route
+                                                .reversed_suffix_segments
+                                                  [s_rank + 1],
                                               s_route.rbegin(),
                                               s_route.rbegin() +
                                                 s_route.size() - 1 - s_rank,
                                               0,
                                               t_rank + 1) and
          _tw_s_route.is_valid_addition_for_tw(_input,
+                                              _tw_t_route
+                                                .reversed_prefix_segments
+                                                  [t_rank + 1],
                                               t_route.rbegin() +
                                                 t_route.size() - 1 - t_rank,
                                               t_route.rend(),
@@ -31,11 +31,15 @@ RouteExchange::RouteExchange(const Input& input,
 bool RouteExchange::is_valid() {
   bool valid = cvrp::RouteExchange::is_valid();
   valid = valid && _tw_t_route.is_valid_addition_for_tw(_input,
+                                                        _tw_s_route
+                                                          .suffix_segments[0],
                                                         s_route.begin(),
                                                         s_route.end(),
                                                         0,
                                                         t_route.size());
   valid = valid && _tw_s_route.is_valid_addition_for_tw(_input,
+                                                        _tw_t_route
+                                                          .suffix_segments[0],
                                                         t_route.begin(),
                                                         t_route.end(),
                                                         0,
@@ -29,9 +29,9 @@ public:
                 TWRoute& tw_t_route,
                 Index t_vehicle);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 };
 
 } // namespace vrptw
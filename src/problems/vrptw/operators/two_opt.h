@@ -31,9 +31,9 @@ public:
          Index t_vehicle,
          Index t_rank);
 
-  virtual bool is_valid() override;
+  bool is_valid();
 
-  virtual void apply() override;
+  void apply();
 };
 
 } // namespace vrptw
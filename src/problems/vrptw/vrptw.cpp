@@ -7,8 +7,6 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <thread>
-
 #include "algorithms/heuristics/solomon.h"
 #include "algorithms/local_search/local_search.h"
 #include "problems/vrptw/operators/cross_exchange.h"
@@ -29,6 +27,7 @@ All rights reserved (see LICENSE).
 #include "structures/vroom/input/input.h"
 #include "structures/vroom/tw_route.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 
@@ -137,6 +136,7 @@ VRPTW::VRPTW(const Input& input) : VRP(input) {
 
 Solution VRPTW::solve(unsigned exploration_level,
                       unsigned nb_threads,
+                      const Deadline& deadline,
                       const std::vector<HeuristicParameters>& h_param) const {
   // Use vector of parameters when passed for debugging, else use
   // predefined parameter set.
@@ -162,56 +162,65 @@ Solution VRPTW::solve(unsigned exploration_level,
 
   std::vector<TWSolution> tw_solutions(nb_init_solutions);
   std::vector<utils::SolutionIndicators> sol_indicators(nb_init_solutions);
-
-  // Split the work among threads.
-  std::vector<std::vector<std::size_t>>
-    thread_ranks(nb_threads, std::vector<std::size_t>());
-  for (std::size_t i = 0; i < nb_init_solutions; ++i) {
-    thread_ranks[i % nb_threads].push_back(i);
-  }
-
-  auto run_solve = [&](const std::vector<std::size_t>& param_ranks) {
-    for (auto rank : param_ranks) {
-      auto& p = parameters[rank];
-      switch (p.heuristic) {
-      case HEURISTIC::BASIC:
-        tw_solutions[rank] =
-          heuristics::basic<TWSolution>(_input, p.init, p.regret_coeff);
-        break;
-      case HEURISTIC::DYNAMIC:
-        tw_solutions[rank] =
-          heuristics::dynamic_vehicle_choice<TWSolution>(_input,
-                                                         p.init,
-                                                         p.regret_coeff);
-        break;
-      }
-
-      // Local search phase.
-      LocalSearch ls(_input, tw_solutions[rank], max_nb_jobs_removal);
-      ls.run();
-
-      // Store solution indicators.
-      sol_indicators[rank] = ls.indicators();
+  std::vector<unsigned char> solved(nb_init_solutions, false);
+  utils::SharedIndicators incumbent;
+
+  // Split the work among threads. Threads left over when there are
+  // less solutions to compute than available threads are used to
+  // parallelize the local search for each solution.
+  unsigned nb_ls_threads = std::max(1u, nb_threads / nb_init_solutions);
+  nb_threads = std::min(nb_threads, nb_init_solutions);
+
+  auto run_solve = [&](std::size_t rank) {
+    if (rank > 0 and utils::deadline_reached(deadline)) {
+      // Out of time, only make sure that at least one solution is
+      // computed.
+      return;
     }
-  };
 
-  std::vector<std::thread> solving_threads;
+    auto& p = parameters[rank];
+    switch (p.heuristic) {
+    case HEURISTIC::BASIC:
+      tw_solutions[rank] =
+        heuristics::basic<TWSolution>(_input, p.init, p.regret_coeff);
+      break;
+    case HEURISTIC::DYNAMIC:
+      tw_solutions[rank] =
+        heuristics::dynamic_vehicle_choice<TWSolution>(_input,
+                                                       p.init,
+                                                       p.regret_coeff);
+      break;
+    }
 
-  for (std::size_t i = 0; i < nb_threads; ++i) {
-    solving_threads.emplace_back(run_solve, thread_ranks[i]);
-  }
+    // Local search phase.
+    LocalSearch ls(_input,
+                   tw_solutions[rank],
+                   max_nb_jobs_removal,
+                   nb_ls_threads,
+                   deadline,
+                   _input.has_seed_pruning() ? &incumbent : nullptr);
+    ls.run();
+
+    // Store solution indicators.
+    sol_indicators[rank] = ls.indicators();
+    solved[rank] = true;
+  };
 
-  for (auto& t : solving_threads) {
-    t.join();
+  // Ranks are handed out one at a time as threads get available, so
+  // that uneven solving times are balanced across threads.
+  utils::ThreadPool::shared().parallel_for(nb_init_solutions,
+                                           nb_threads,
+                                           run_solve);
+
+  // Pick best solution among those computed before deadline.
+  std::size_t best_rank = 0;
+  for (std::size_t rank = 1; rank < nb_init_solutions; ++rank) {
+    if (solved[rank] and sol_indicators[rank] < sol_indicators[best_rank]) {
+      best_rank = rank;
+    }
   }
 
-  auto best_indic =
-    std::min_element(sol_indicators.cbegin(), sol_indicators.cend());
-
-  return utils::format_solution(_input,
-                                tw_solutions[std::distance(sol_indicators
-                                                             .cbegin(),
-                                                           best_indic)]);
+  return utils::format_solution(_input, tw_solutions[best_rank]);
 }
 
 } // namespace vroom
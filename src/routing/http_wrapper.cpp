@@ -7,6 +7,14 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
 #include <asio.hpp>
 #include <asio/ssl.hpp>
 
@@ -19,157 +27,627 @@ namespace routing {
 
 const std::string HttpWrapper::HTTPS_PORT = "443";
 
+struct HttpWrapper::Connection {
+  asio::io_service io_service;
+  std::optional<tcp::socket> socket;
+  std::optional<asio::ssl::stream<tcp::socket>> ssl_stream;
+
+  // Bytes already received past the end of previous response.
+  std::string buffer;
+};
+
+struct HttpWrapper::ConnectionPool {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Connection>> idle_connections;
+
+  asio::ssl::context ssl_context{asio::ssl::context::method::sslv23_client};
+
+  // Latest TLS session, used to resume sessions on new connections.
+  SSL_SESSION* tls_session{nullptr};
+
+  // Sessions are received through a callback as TLS 1.3 servers only
+  // send session tickets after the handshake, along with response
+  // data.
+  // Application data slot is used by asio, so the pool is stored in
+  // its own ex_data index.
+  static int ex_data_index() {
+    static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+  }
+
+  static int on_new_session(SSL* ssl, SSL_SESSION* session) {
+    auto* pool = static_cast<ConnectionPool*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ex_data_index()));
+
+    std::scoped_lock<std::mutex> lock(pool->mutex);
+    if (pool->tls_session != nullptr) {
+      SSL_SESSION_free(pool->tls_session);
+    }
+    pool->tls_session = session;
+
+    // Keep the reference passed to the callback.
+    return 1;
+  }
+
+  ConnectionPool() {
+    auto* ctx = ssl_context.native_handle();
+    SSL_CTX_set_ex_data(ctx, ex_data_index(), this);
+    SSL_CTX_set_session_cache_mode(ctx,
+                                   SSL_SESS_CACHE_CLIENT |
+                                     SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &on_new_session);
+  }
+
+  ~ConnectionPool() {
+    if (tls_session != nullptr) {
+      SSL_SESSION_free(tls_session);
+    }
+  }
+};
+
 HttpWrapper::HttpWrapper(const std::string& profile,
                          const Server& server,
                          const std::string& matrix_service,
                          const std::string& route_service,
                          const std::string& extra_args)
   : Wrapper(profile),
+    _pool(std::make_unique<ConnectionPool>()),
     _server(server),
     _matrix_service(matrix_service),
     _route_service(route_service),
     _extra_args(extra_args) {
 }
 
-std::string HttpWrapper::send_then_receive(const std::string& query) const {
-  std::string response;
+HttpWrapper::~HttpWrapper() = default;
 
-  try {
-    asio::io_service io_service;
+std::unique_ptr<HttpWrapper::Connection> HttpWrapper::connect() const {
+  auto connection = std::make_unique<Connection>();
 
-    tcp::resolver r(io_service);
+  tcp::resolver r(connection->io_service);
+  tcp::resolver::query q(_server.host, _server.port);
 
-    tcp::resolver::query q(_server.host, _server.port);
+  if (_server.port != HTTPS_PORT) {
+    connection->socket.emplace(connection->io_service);
+    asio::connect(*connection->socket, r.resolve(q));
+    return connection;
+  }
 
-    tcp::socket s(io_service);
-    asio::connect(s, r.resolve(q));
+  auto& ssock =
+    connection->ssl_stream.emplace(connection->io_service, _pool->ssl_context);
+  asio::connect(ssock.lowest_layer(), r.resolve(q));
 
-    asio::write(s, asio::buffer(query));
+  {
+    std::scoped_lock<std::mutex> lock(_pool->mutex);
+    if (_pool->tls_session != nullptr) {
+      SSL_set_session(ssock.native_handle(), _pool->tls_session);
+    }
+  }
 
-    char buf[512];
-    std::error_code error;
-    for (;;) {
-      std::size_t len = s.read_some(asio::buffer(buf), error);
-      response.append(buf, len);
-      if (error == asio::error::eof) {
-        // Connection closed cleanly.
-        break;
-      } else {
-        if (error) {
-          throw std::system_error(error);
-        }
+  ssock.handshake(asio::ssl::stream_base::handshake_type::client);
+
+  return connection;
+}
+
+class HttpWrapper::ResponseStream {
+public:
+  using Ch = char;
+
+  // Read up to size bytes to data, returning 0 on connection end.
+  using ReadFunction = std::function<std::size_t(char* data, std::size_t size)>;
+
+private:
+  static constexpr std::size_t READ_SIZE = 1 << 16;
+
+  // Connection buffer, holding bytes received but not consumed yet
+  // from rank _pos on.
+  std::string& _buffer;
+  std::size_t _pos{0};
+  const ReadFunction _read_some;
+
+  bool _keep_alive{true};
+  bool _chunked{false};
+  bool _first_chunk{true};
+  // Body is read until connection end if no length is provided.
+  bool _until_close{false};
+  bool _done{false};
+
+  // Body bytes left in current chunk (or whole body).
+  std::size_t _remaining{0};
+  std::size_t _count{0};
+
+  // Receive more bytes, return false on connection end.
+  bool fill() {
+    _buffer.erase(0, _pos);
+    _pos = 0;
+
+    const auto size = _buffer.size();
+    _buffer.resize(size + READ_SIZE);
+    const auto len = _read_some(_buffer.data() + size, READ_SIZE);
+    _buffer.resize(size + len);
+
+    return len > 0;
+  }
+
+  void require(std::size_t size) {
+    while (_buffer.size() - _pos < size) {
+      if (!fill()) {
+        throw std::system_error(asio::error::eof);
       }
     }
-  } catch (std::system_error& e) {
-    throw Exception(ERROR::ROUTING,
-                    "Failed to connect to " + _server.host + ":" +
-                      _server.port);
   }
 
-  // Removing headers.
-  auto start = response.find("{");
-  assert(start != std::string::npos);
-  auto end = response.rfind("}");
-  assert(end != std::string::npos);
+  // Return next CRLF-terminated line, consuming it.
+  std::string read_line() {
+    auto end = _buffer.find("\r\n", _pos);
+    while (end == std::string::npos) {
+      if (!fill()) {
+        throw std::system_error(asio::error::eof);
+      }
+      end = _buffer.find("\r\n", _pos);
+    }
 
-  std::string json_content = response.substr(start, end - start + 1);
+    std::string line = _buffer.substr(_pos, end - _pos);
+    _pos = end + 2;
+    return line;
+  }
 
-  return json_content;
-}
+  // Move to next body chunk, return false at the end of the body.
+  bool next_chunk() {
+    if (_done) {
+      return false;
+    }
+    if (!_chunked) {
+      _done = true;
+      return false;
+    }
 
-std::string HttpWrapper::ssl_send_then_receive(const std::string& query) const {
-  std::string response;
+    if (!_first_chunk) {
+      // CRLF after previous chunk data.
+      require(2);
+      _pos += 2;
+    }
+    _first_chunk = false;
 
-  try {
-    asio::io_service io_service;
+    _remaining = std::stoul(read_line(), nullptr, 16);
+    if (_remaining == 0) {
+      // Skip trailer headers up to the final empty line.
+      while (!read_line().empty()) {
+      }
+      _done = true;
+      return false;
+    }
 
-    asio::ssl::context ctx(asio::ssl::context::method::sslv23_client);
-    asio::ssl::stream<asio::ip::tcp::socket> ssock(io_service, ctx);
+    return true;
+  }
 
-    tcp::resolver r(io_service);
+public:
+  ResponseStream(std::string& buffer, ReadFunction read_some)
+    : _buffer(buffer), _read_some(std::move(read_some)) {
+  }
 
-    tcp::resolver::query q(_server.host, _server.port);
+  ~ResponseStream() {
+    // Keep bytes past the end of response for next one.
+    _buffer.erase(0, _pos);
+  }
 
-    asio::connect(ssock.lowest_layer(), r.resolve(q));
-    ssock.handshake(asio::ssl::stream_base::handshake_type::client);
+  bool keep_alive() const {
+    return _keep_alive;
+  }
 
-    asio::write(ssock, asio::buffer(query));
+  // Parse status line and headers.
+  void read_headers() {
+    if (read_line().compare(0, 8, "HTTP/1.0") == 0) {
+      _keep_alive = false;
+    }
 
-    char buf[512];
-    std::error_code error;
-    for (;;) {
-      std::size_t len = ssock.read_some(asio::buffer(buf), error);
-      response.append(buf, len);
-      if (error == asio::error::eof) {
-        // Connection closed cleanly.
-        break;
-      } else {
-        if (error) {
-          throw std::system_error(error);
+    bool has_length = false;
+    for (auto header = read_line(); !header.empty(); header = read_line()) {
+      std::transform(header.begin(),
+                     header.end(),
+                     header.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+
+      if (header.rfind("content-length:", 0) == 0) {
+        _remaining = std::stoul(header.substr(15));
+        has_length = true;
+      } else if (header.rfind("transfer-encoding:", 0) == 0) {
+        _chunked = (header.find("chunked") != std::string::npos);
+      } else if (header.rfind("connection:", 0) == 0) {
+        if (header.find("close") != std::string::npos) {
+          _keep_alive = false;
+        } else if (header.find("keep-alive") != std::string::npos) {
+          _keep_alive = true;
         }
       }
     }
-  } catch (std::system_error& e) {
-    throw Exception(ERROR::ROUTING,
-                    "Failed to connect to " + _server.host + ":" +
-                      _server.port);
+
+    if (!_chunked and !has_length) {
+      // No way to spot the end of the body but connection closing.
+      _until_close = true;
+      _keep_alive = false;
+      _remaining = std::numeric_limits<std::size_t>::max();
+    }
   }
 
-  // Removing headers.
-  auto start = response.find("{");
-  assert(start != std::string::npos);
-  auto end = response.rfind("}");
-  assert(end != std::string::npos);
+  // Skip what is left of the body.
+  void finish() {
+    while (Peek() != '\0') {
+      const auto skipped = std::min(_remaining, _buffer.size() - _pos);
+      _pos += skipped;
+      _remaining -= skipped;
+      _count += skipped;
+    }
+  }
 
-  std::string json_content = response.substr(start, end - start + 1);
+  // rapidjson input stream interface.
+  Ch Peek() {
+    if (_until_close) {
+      if (_pos == _buffer.size() and (_done or !fill())) {
+        _done = true;
+        return '\0';
+      }
+      return _buffer[_pos];
+    }
 
-  return json_content;
-}
+    if (_remaining == 0 and !next_chunk()) {
+      return '\0';
+    }
+    require(1);
+    return _buffer[_pos];
+  }
 
-std::string HttpWrapper::run_query(const std::string& query) const {
-  return (_server.port == HTTPS_PORT) ? ssl_send_then_receive(query)
-                                      : send_then_receive(query);
-}
+  Ch Take() {
+    const Ch c = Peek();
+    if (c != '\0') {
+      ++_pos;
+      --_remaining;
+      ++_count;
+    }
+    return c;
+  }
+
+  std::size_t Tell() const {
+    return _count;
+  }
+
+  Ch* PutBegin() {
+    assert(false);
+    return nullptr;
+  }
+  void Put(Ch) {
+    assert(false);
+  }
+  void Flush() {
+    assert(false);
+  }
+  std::size_t PutEnd(Ch*) {
+    assert(false);
+    return 0;
+  }
+};
+
+// SAX handler building a document from a routing response, except
+// for the top-level "durations" and "distances" members whose values
+// are directly handed to on_value(table, i, j, value), with table 0
+// for durations and 1 for distances and value empty for 'null'.
+template <class ValueCallback> class TableHandler {
+private:
+  rapidjson::Document& _infos;
+  ValueCallback& _on_value;
+
+  // Nesting level for values forwarded to _infos.
+  unsigned _depth{0};
+  rapidjson::SizeType _skipped_members{0};
+
+  // Table for upcoming array, if any.
+  std::optional<unsigned> _next_table;
+  unsigned _table{0};
+  // Nesting level inside current table array.
+  unsigned _table_depth{0};
+  std::array<rapidjson::SizeType, 2> _nb_rows{0, 0};
+  rapidjson::SizeType _j{0};
+
+  bool value(const std::optional<double>& v) {
+    if (_table_depth != 2) {
+      return false;
+    }
+    return _on_value(_table, _nb_rows[_table], _j++, v);
+  }
 
-Matrix<Cost> HttpWrapper::get_matrix(const std::vector<Location>& locs) const {
-  std::string query = this->build_query(locs, _matrix_service);
-  std::string json_content = this->run_query(query);
+public:
+  TableHandler(rapidjson::Document& infos, ValueCallback& on_value)
+    : _infos(infos), _on_value(on_value) {
+  }
 
-  // Expected matrix size.
-  std::size_t m_size = locs.size();
+  rapidjson::SizeType nb_rows(unsigned table) const {
+    return _nb_rows[table];
+  }
 
-  rapidjson::Document infos;
-  this->parse_response(infos, json_content);
-
-  assert(infos["durations"].Size() == m_size);
-
-  // Build matrix while checking for unfound routes ('null' values) to
-  // avoid unexpected behavior.
-  Matrix<Cost> m(m_size);
-
-  std::vector<unsigned> nb_unfound_from_loc(m_size, 0);
-  std::vector<unsigned> nb_unfound_to_loc(m_size, 0);
-
-  for (rapidjson::SizeType i = 0; i < infos["durations"].Size(); ++i) {
-    const auto& line = infos["durations"][i];
-    assert(line.Size() == m_size);
-    for (rapidjson::SizeType j = 0; j < line.Size(); ++j) {
-      if (line[j].IsNull()) {
-        // No route found between i and j. Just storing info as we
-        // don't know yet which location is responsible between i
-        // and j.
-        ++nb_unfound_from_loc[i];
-        ++nb_unfound_to_loc[j];
+  bool Null() {
+    return (_table_depth > 0) ? value(std::nullopt) : _infos.Null();
+  }
+  bool Bool(bool b) {
+    return (_table_depth > 0) ? false : _infos.Bool(b);
+  }
+  bool Int(int i) {
+    return (_table_depth > 0) ? value(i) : _infos.Int(i);
+  }
+  bool Uint(unsigned i) {
+    return (_table_depth > 0) ? value(i) : _infos.Uint(i);
+  }
+  bool Int64(int64_t i) {
+    return (_table_depth > 0) ? value(i) : _infos.Int64(i);
+  }
+  bool Uint64(uint64_t i) {
+    return (_table_depth > 0) ? value(i) : _infos.Uint64(i);
+  }
+  bool Double(double d) {
+    return (_table_depth > 0) ? value(d) : _infos.Double(d);
+  }
+  bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) {
+    return (_table_depth > 0) ? false : _infos.RawNumber(str, length, copy);
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool copy) {
+    return (_table_depth > 0) ? false : _infos.String(str, length, copy);
+  }
+
+  bool StartObject() {
+    if (_next_table or _table_depth > 0) {
+      return false;
+    }
+    ++_depth;
+    return _infos.StartObject();
+  }
+
+  bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+    if (_depth == 1) {
+      const std::string_view key(str, length);
+      if (key == "durations") {
+        _next_table = 0;
+      } else if (key == "distances") {
+        _next_table = 1;
+      }
+      if (_next_table) {
+        ++_skipped_members;
+        return true;
+      }
+    }
+    return _infos.Key(str, length, copy);
+  }
+
+  bool EndObject(rapidjson::SizeType member_count) {
+    --_depth;
+    if (_depth == 0) {
+      member_count -= _skipped_members;
+    }
+    return _infos.EndObject(member_count);
+  }
+
+  bool StartArray() {
+    if (_next_table) {
+      _table = _next_table.value();
+      _next_table.reset();
+      _table_depth = 1;
+      return true;
+    }
+    if (_table_depth > 0) {
+      if (_table_depth == 2) {
+        return false;
+      }
+      _table_depth = 2;
+      _j = 0;
+      return true;
+    }
+    ++_depth;
+    return _infos.StartArray();
+  }
+
+  bool EndArray(rapidjson::SizeType element_count) {
+    if (_table_depth == 2) {
+      ++_nb_rows[_table];
+    }
+    if (_table_depth > 0) {
+      --_table_depth;
+      return true;
+    }
+    --_depth;
+    return _infos.EndArray(element_count);
+  }
+};
+
+void HttpWrapper::run_query(
+  const std::string& query,
+  const std::function<void(ResponseStream&)>& parse) const {
+  std::unique_ptr<Connection> connection;
+  {
+    std::scoped_lock<std::mutex> lock(_pool->mutex);
+    if (!_pool->idle_connections.empty()) {
+      connection = std::move(_pool->idle_connections.back());
+      _pool->idle_connections.pop_back();
+    }
+  }
+  bool reused = (connection != nullptr);
+
+  for (;;) {
+    bool received = false;
+    try {
+      if (!connection) {
+        connection = connect();
+      }
+
+      auto read_some = [&](char* data, std::size_t size) {
+        std::error_code error;
+        std::size_t len =
+          (connection->ssl_stream)
+            ? connection->ssl_stream->read_some(asio::buffer(data, size),
+                                                error)
+            : connection->socket->read_some(asio::buffer(data, size), error);
+        // Servers often close TLS connections without a shutdown
+        // notification, which is fine for responses read until
+        // connection end. Truncated responses with a known length are
+        // caught by response framing.
+        if (error and error != asio::error::eof and
+            error != asio::ssl::error::stream_truncated) {
+          throw std::system_error(error);
+        }
+        received = received or (len > 0);
+        return len;
+      };
+
+      if (connection->ssl_stream) {
+        asio::write(*connection->ssl_stream, asio::buffer(query));
       } else {
-        auto cost = round_cost(line[j].GetDouble());
-        m[i][j] = cost;
+        asio::write(*connection->socket, asio::buffer(query));
+      }
+
+      bool keep_alive;
+      {
+        ResponseStream response(connection->buffer, read_some);
+        response.read_headers();
+        parse(response);
+        response.finish();
+        keep_alive = response.keep_alive();
+      }
+
+      if (keep_alive) {
+        std::scoped_lock<std::mutex> lock(_pool->mutex);
+        _pool->idle_connections.push_back(std::move(connection));
+      } else if (connection->ssl_stream) {
+        // OpenSSL discards sessions from connections closed without a
+        // shutdown notification, so close cleanly to allow resumption.
+        std::error_code error;
+        connection->ssl_stream->shutdown(error);
+      }
+      return;
+    } catch (std::system_error& e) {
+      if (reused and !received) {
+        // Idle connection may have been closed on server side in the
+        // meantime, so retry with a new one.
+        connection.reset();
+        reused = false;
+        continue;
       }
+      throw Exception(ERROR::ROUTING,
+                      "Failed to connect to " + _server.host + ":" +
+                        _server.port);
+    } catch (std::logic_error& e) {
+      // Invalid numerical value in headers.
+      throw Exception(ERROR::ROUTING,
+                      "Invalid response from " + _server.host + ":" +
+                        _server.port);
     }
   }
+}
 
-  check_unfound(locs, nb_unfound_from_loc, nb_unfound_to_loc);
+void HttpWrapper::fill_matrix_tile(
+  const std::vector<Location>& locs,
+  const std::vector<Index>& sources,
+  const std::vector<Index>& destinations,
+  Matrix<Cost>& m,
+  Matrix<Distance>* distances,
+  std::vector<unsigned>& nb_unfound_from_source,
+  std::vector<unsigned>& nb_unfound_to_destination) const {
+  std::vector<Location> tile_locs;
+  for (const auto i : sources) {
+    tile_locs.push_back(locs[i]);
+  }
 
-  return m;
+  unsigned nb_sources = 0;
+  unsigned nb_destinations = 0;
+  if (sources != destinations) {
+    // Sources come first in query locations, then destinations.
+    for (const auto j : destinations) {
+      tile_locs.push_back(locs[j]);
+    }
+    nb_sources = sources.size();
+    nb_destinations = destinations.size();
+  }
+
+  std::string query =
+    this->build_query(tile_locs,
+                      _matrix_service,
+                      this->matrix_args(nb_sources,
+                                        nb_destinations,
+                                        distances != nullptr));
+
+  // Fill matrices while parsing and check for unfound routes ('null'
+  // values) to avoid unexpected behavior.
+  auto on_value = [&](unsigned table,
+                      rapidjson::SizeType i,
+                      rapidjson::SizeType j,
+                      const std::optional<double>& value) {
+    if (i >= sources.size() or j >= destinations.size()) {
+      return false;
+    }
+    if (table == 1) {
+      if (distances != nullptr and value) {
+        (*distances)[sources[i]][destinations[j]] = round_cost(*value);
+      }
+      return true;
+    }
+    if (value) {
+      m[sources[i]][destinations[j]] = round_cost(*value);
+    } else {
+      // No route found between i and j. Just storing info as we
+      // don't know yet which location is responsible between i and
+      // j.
+      ++nb_unfound_from_source[i];
+      ++nb_unfound_to_destination[j];
+    }
+    return true;
+  };
+
+  rapidjson::Document infos;
+  std::array<rapidjson::SizeType, 2> nb_rows{0, 0};
+  bool parse_error = false;
+
+  this->run_query(query, [&](ResponseStream& response) {
+    rapidjson::Reader reader;
+    TableHandler<decltype(on_value)> handler(infos, on_value);
+    auto generator = [&](rapidjson::Document&) {
+      return !reader
+                .Parse<rapidjson::kParseStopWhenDoneFlag>(response, handler)
+                .IsError();
+    };
+    infos.Populate(generator);
+    parse_error = reader.HasParseError();
+    nb_rows = {handler.nb_rows(0), handler.nb_rows(1)};
+  });
+
+  if (parse_error) {
+    throw Exception(ERROR::ROUTING,
+                    "Invalid response from " + _server.host + ":" +
+                      _server.port);
+  }
+  this->check_response(infos);
+
+  assert(nb_rows[0] == sources.size());
+  assert(distances == nullptr or nb_rows[1] == sources.size());
+}
+
+void HttpWrapper::fill_matrix(const std::vector<Location>& locs,
+                              const std::vector<Index>& sources,
+                              const std::vector<Index>& destinations,
+                              Matrix<Cost>& m,
+                              Matrix<Distance>* distances) const {
+  fill_tiled_matrix(locs,
+                    sources,
+                    destinations,
+                    m,
+                    [&](const auto& tile_sources,
+                        const auto& tile_destinations,
+                        auto& tile_m,
+                        auto& nb_unfound_from_source,
+                        auto& nb_unfound_to_destination) {
+                      fill_matrix_tile(locs,
+                                       tile_sources,
+                                       tile_destinations,
+                                       tile_m,
+                                       distances,
+                                       nb_unfound_from_source,
+                                       nb_unfound_to_destination);
+                    });
 }
 
 void HttpWrapper::add_route_info(Route& route) const {
@@ -193,10 +671,17 @@ void HttpWrapper::add_route_info(Route& route) const {
   std::string query =
     build_query(non_break_locations, _route_service, _extra_args);
 
-  std::string json_content = this->run_query(query);
-
   rapidjson::Document infos;
-  parse_response(infos, json_content);
+  this->run_query(query, [&](ResponseStream& response) {
+    infos.ParseStream<rapidjson::kParseStopWhenDoneFlag>(response);
+  });
+
+  if (infos.HasParseError()) {
+    throw Exception(ERROR::ROUTING,
+                    "Invalid response from " + _server.host + ":" +
+                      _server.port);
+  }
+  this->check_response(infos);
 
   // Total distance and route geometry.
   route.distance = round_cost(get_total_distance(infos["routes"][0]));
@@ -9,6 +9,8 @@ Copyright (c) 2015-2020, Julien Coupey.
 All rights reserved (see LICENSE).
 
 */
+#include <memory>
+
 #include "../include/rapidjson/document.h"
 #include "../include/rapidjson/error/en.h"
 
@@ -21,12 +23,33 @@ namespace routing {
 
 class HttpWrapper : public Wrapper {
 private:
-  std::string send_then_receive(const std::string& query) const;
+  // Open connections and TLS state, shared across concurrent
+  // queries.
+  struct Connection;
+  struct ConnectionPool;
+  const std::unique_ptr<ConnectionPool> _pool;
+
+  std::unique_ptr<Connection> connect() const;
+
+  // Response body read as a rapidjson input stream, directly from
+  // the connection.
+  class ResponseStream;
 
-  std::string ssl_send_then_receive(const std::string& query) const;
+  // Send query then let parse consume the response body as it
+  // arrives. Connections are kept alive and reused across queries.
+  void run_query(const std::string& query,
+                 const std::function<void(ResponseStream&)>& parse) const;
 
   static const std::string HTTPS_PORT;
 
+  void fill_matrix_tile(const std::vector<Location>& locs,
+                        const std::vector<Index>& sources,
+                        const std::vector<Index>& destinations,
+                        Matrix<Cost>& m,
+                        Matrix<Distance>* distances,
+                        std::vector<unsigned>& nb_unfound_from_source,
+                        std::vector<unsigned>& nb_unfound_to_destination) const;
+
 protected:
   const Server _server;
   const std::string _matrix_service;
@@ -39,17 +62,27 @@ protected:
               const std::string& route_service,
               const std::string& extra_args);
 
-  std::string run_query(const std::string& query) const;
+  ~HttpWrapper();
 
   virtual std::string build_query(const std::vector<Location>& locations,
                                   const std::string& service,
                                   const std::string& extra_args = "") const = 0;
 
-  virtual void parse_response(rapidjson::Document& input,
-                              const std::string& json_content) const = 0;
-
-  virtual Matrix<Cost>
-  get_matrix(const std::vector<Location>& locs) const override;
+  // Extra arguments for a matrix query, from nb_sources first
+  // locations to nb_destinations last locations (all locations both
+  // ways if nb_sources is 0), also asking for distances if required.
+  virtual std::string matrix_args(unsigned nb_sources,
+                                  unsigned nb_destinations,
+                                  bool distances) const = 0;
+
+  // Throw if infos holds an error returned by the routing engine.
+  virtual void check_response(const rapidjson::Document& infos) const = 0;
+
+  virtual void fill_matrix(const std::vector<Location>& locs,
+                           const std::vector<Index>& sources,
+                           const std::vector<Index>& destinations,
+                           Matrix<Cost>& m,
+                           Matrix<Distance>* distances) const override;
 
   virtual double get_total_distance(const rapidjson::Value& route) const = 0;
 
@@ -32,14 +32,37 @@ LibosrmWrapper::LibosrmWrapper(const std::string& profile)
   : Wrapper(profile), _config(get_config(profile)), _osrm(_config) {
 }
 
-Matrix<Cost>
-LibosrmWrapper::get_matrix(const std::vector<Location>& locs) const {
+void LibosrmWrapper::fill_matrix_tile(
+  const std::vector<Location>& locs,
+  const std::vector<Index>& sources,
+  const std::vector<Index>& destinations,
+  Matrix<Cost>& m,
+  Matrix<Distance>* distances,
+  std::vector<unsigned>& nb_unfound_from_source,
+  std::vector<unsigned>& nb_unfound_to_destination) const {
   osrm::TableParameters params;
-  for (auto const& location : locs) {
+  auto add_coordinates = [&](const Location& location) {
     assert(location.has_coordinates());
     params.coordinates
       .emplace_back(osrm::util::FloatLongitude({location.lon()}),
                     osrm::util::FloatLatitude({location.lat()}));
+  };
+
+  for (const auto i : sources) {
+    add_coordinates(locs[i]);
+  }
+  if (sources != destinations) {
+    // Sources come first in coordinates, then destinations.
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      params.sources.push_back(i);
+    }
+    for (std::size_t j = 0; j < destinations.size(); ++j) {
+      add_coordinates(locs[destinations[j]]);
+      params.destinations.push_back(sources.size() + j);
+    }
+  }
+  if (distances != nullptr) {
+    params.annotations = osrm::TableParameters::AnnotationsType::All;
   }
 
   osrm::json::Object result;
@@ -54,40 +77,68 @@ LibosrmWrapper::get_matrix(const std::vector<Location>& locs) const {
   }
 
   auto& table = result.values["durations"].get<osrm::json::Array>();
+  assert(table.values.size() == sources.size());
 
-  // Expected matrix size.
-  std::size_t m_size = locs.size();
-  assert(table.values.size() == m_size);
-
-  // Build matrix while checking for unfound routes to avoid
+  // Fill matrix while checking for unfound routes to avoid
   // unexpected behavior (OSRM raises 'null').
-  Matrix<Cost> m(m_size);
-
-  std::vector<unsigned> nb_unfound_from_loc(m_size, 0);
-  std::vector<unsigned> nb_unfound_to_loc(m_size, 0);
-
-  std::string reason;
-  for (std::size_t i = 0; i < m_size; ++i) {
+  for (std::size_t i = 0; i < sources.size(); ++i) {
     const auto& line = table.values.at(i).get<osrm::json::Array>();
-    assert(line.values.size() == m_size);
-    for (std::size_t j = 0; j < m_size; ++j) {
+    assert(line.values.size() == destinations.size());
+    for (std::size_t j = 0; j < destinations.size(); ++j) {
       const auto& el = line.values.at(j);
       if (el.is<osrm::json::Null>()) {
         // No route found between i and j. Just storing info as we
         // don't know yet which location is responsible between i
         // and j.
-        ++nb_unfound_from_loc[i];
-        ++nb_unfound_to_loc[j];
+        ++nb_unfound_from_source[i];
+        ++nb_unfound_to_destination[j];
       } else {
-        auto cost = round_cost(el.get<osrm::json::Number>().value);
-        m[i][j] = cost;
+        m[sources[i]][destinations[j]] =
+          round_cost(el.get<osrm::json::Number>().value);
       }
     }
   }
 
-  check_unfound(locs, nb_unfound_from_loc, nb_unfound_to_loc);
+  if (distances != nullptr) {
+    auto& dist_table = result.values["distances"].get<osrm::json::Array>();
+    assert(dist_table.values.size() == sources.size());
+
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      const auto& line = dist_table.values.at(i).get<osrm::json::Array>();
+      assert(line.values.size() == destinations.size());
+      for (std::size_t j = 0; j < destinations.size(); ++j) {
+        const auto& el = line.values.at(j);
+        if (!el.is<osrm::json::Null>()) {
+          (*distances)[sources[i]][destinations[j]] =
+            round_cost(el.get<osrm::json::Number>().value);
+        }
+      }
+    }
+  }
+}
 
-  return m;
+void LibosrmWrapper::fill_matrix(const std::vector<Location>& locs,
+                                 const std::vector<Index>& sources,
+                                 const std::vector<Index>& destinations,
+                                 Matrix<Cost>& m,
+                                 Matrix<Distance>* distances) const {
+  fill_tiled_matrix(locs,
+                    sources,
+                    destinations,
+                    m,
+                    [&](const auto& tile_sources,
+                        const auto& tile_destinations,
+                        auto& tile_m,
+                        auto& nb_unfound_from_source,
+                        auto& nb_unfound_to_destination) {
+                      fill_matrix_tile(locs,
+                                       tile_sources,
+                                       tile_destinations,
+                                       tile_m,
+                                       distances,
+                                       nb_unfound_from_source,
+                                       nb_unfound_to_destination);
+                    });
 }
 
 void LibosrmWrapper::add_route_info(Route& route) const {
@@ -26,11 +26,22 @@ private:
 
   static osrm::EngineConfig get_config(const std::string& profile);
 
+  void fill_matrix_tile(const std::vector<Location>& locs,
+                        const std::vector<Index>& sources,
+                        const std::vector<Index>& destinations,
+                        Matrix<Cost>& m,
+                        Matrix<Distance>* distances,
+                        std::vector<unsigned>& nb_unfound_from_source,
+                        std::vector<unsigned>& nb_unfound_to_destination) const;
+
 public:
   LibosrmWrapper(const std::string& profile);
 
-  virtual Matrix<Cost>
-  get_matrix(const std::vector<Location>& locs) const override;
+  virtual void fill_matrix(const std::vector<Location>& locs,
+                           const std::vector<Index>& sources,
+                           const std::vector<Index>& destinations,
+                           Matrix<Cost>& m,
+                           Matrix<Distance>* distances) const override;
 
   virtual void add_route_info(Route& route) const override;
 };
@@ -0,0 +1,392 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "routing/matrix_cache.h"
+
+namespace vroom {
+namespace routing {
+
+namespace {
+
+// Cache files are only read or written while holding a flock, which
+// is released when closing the file descriptor. The lock is shared for
+// files opened read-only.
+class LockedFile {
+private:
+  const std::string _path;
+  int _fd;
+
+  [[noreturn]] void fail(const std::string& action) const {
+    throw Exception(ERROR::INPUT,
+                    "Failed to " + action + " matrix cache file " + _path +
+                      ": " + std::strerror(errno) + ".");
+  }
+
+public:
+  LockedFile(const std::string& path, int flags) : _path(path) {
+    _fd = open(path.c_str(), flags, 0644);
+    if (_fd < 0) {
+      if (errno == ENOENT and !(flags & O_CREAT)) {
+        return;
+      }
+      fail("open");
+    }
+    const bool read_only = (flags & O_ACCMODE) == O_RDONLY;
+    if (flock(_fd, read_only ? LOCK_SH : LOCK_EX) != 0) {
+      close(_fd);
+      fail("lock");
+    }
+  }
+
+  LockedFile(const LockedFile&) = delete;
+  LockedFile& operator=(const LockedFile&) = delete;
+
+  ~LockedFile() {
+    if (_fd >= 0) {
+      close(_fd);
+    }
+  }
+
+  bool exists() const {
+    return _fd >= 0;
+  }
+
+  std::size_t size() const {
+    struct stat st;
+    if (fstat(_fd, &st) != 0) {
+      fail("stat");
+    }
+    return st.st_size;
+  }
+
+  std::string read_all() const {
+    std::string content(size(), '\0');
+    std::size_t done = 0;
+    while (done < content.size()) {
+      const auto n =
+        pread(_fd, content.data() + done, content.size() - done, done);
+      if (n <= 0) {
+        if (n < 0 and errno == EINTR) {
+          continue;
+        }
+        fail("read");
+      }
+      done += n;
+    }
+    return content;
+  }
+
+  void truncate(std::size_t size) const {
+    if (ftruncate(_fd, size) != 0) {
+      fail("truncate");
+    }
+  }
+
+  void write_all(const std::string& buffer) const {
+    std::size_t done = 0;
+    while (done < buffer.size()) {
+      const auto n = write(_fd, buffer.data() + done, buffer.size() - done);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        fail("write");
+      }
+      done += n;
+    }
+  }
+};
+
+} // namespace
+
+MatrixCache::MatrixCache(std::unique_ptr<Wrapper> wrapper,
+                         const std::string& directory,
+                         const std::string& source)
+  : Wrapper(wrapper->profile),
+    _wrapper(std::move(wrapper)),
+    _durations(
+      {get_file_stem(directory, source, profile) + ".matrix", false, {}}),
+    _distances(
+      {get_file_stem(directory, source, profile) + ".distances", false, {}}) {
+  // Report a wrong directory before paying for any routing request.
+  struct stat st;
+  if (stat(directory.c_str(), &st) != 0 or !S_ISDIR(st.st_mode)) {
+    throw Exception(ERROR::INPUT,
+                    "Invalid matrix cache directory " + directory + ".");
+  }
+
+  // New files can't be created in a read-only directory.
+  const bool read_only = access(directory.c_str(), W_OK) != 0;
+  _durations.read_only = read_only;
+  _distances.read_only = read_only;
+
+  load(_durations);
+  load(_distances);
+}
+
+std::string MatrixCache::get_file_stem(const std::string& directory,
+                                       const std::string& source,
+                                       const std::string& profile) {
+  std::string name = source + "_" + profile;
+  std::replace_if(name.begin(),
+                  name.end(),
+                  [](char c) {
+                    return !std::isalnum(static_cast<unsigned char>(c)) and
+                           c != '-' and c != '.' and c != '_';
+                  },
+                  '_');
+  return directory + "/" + name;
+}
+
+MatrixCache::CoordinatesPair MatrixCache::get_pair(const Location& from,
+                                                   const Location& to) {
+  assert(from.has_coordinates() and to.has_coordinates());
+  return {from.lon(), from.lat(), to.lon(), to.lat()};
+}
+
+template <class T> MatrixCache::Header MatrixCache::get_header() {
+  constexpr char version = 1;
+  const uint16_t one = 1;
+  const bool little_endian = *reinterpret_cast<const char*>(&one) == 1;
+
+  return {'V',
+          'R',
+          'M',
+          'C',
+          version,
+          static_cast<char>(sizeof(Coordinate)),
+          static_cast<char>(sizeof(T)),
+          little_endian ? 'l' : 'b'};
+}
+
+template <class T>
+void MatrixCache::append_record(std::string& buffer,
+                                const CoordinatesPair& pair,
+                                T value) {
+  buffer.append(reinterpret_cast<const char*>(pair.data()), sizeof(pair));
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T> void MatrixCache::load(Table<T>& table) {
+  // Existing files may be writable or not, whatever the directory.
+  if (access(table.file_path.c_str(), F_OK) == 0) {
+    table.read_only = access(table.file_path.c_str(), W_OK) != 0;
+  }
+
+  // A missing file simply means an empty cache.
+  LockedFile file(table.file_path, table.read_only ? O_RDONLY : O_RDWR);
+  if (!file.exists()) {
+    return;
+  }
+
+  const auto content = file.read_all();
+  const auto header = get_header<T>();
+  if (content.size() < header.size() or
+      !std::equal(header.begin(), header.end(), content.begin())) {
+    throw Exception(ERROR::INPUT,
+                    "Incompatible matrix cache file " + table.file_path +
+                      ".");
+  }
+
+  constexpr auto record_size = Table<T>::record_size;
+  const std::size_t nb_records =
+    (content.size() - header.size()) / record_size;
+
+  const char* current = content.data() + header.size();
+  CoordinatesPair pair;
+  T value;
+  for (std::size_t r = 0; r < nb_records; ++r) {
+    std::copy_n(current, sizeof(pair), reinterpret_cast<char*>(pair.data()));
+    std::copy_n(current + sizeof(pair),
+                sizeof(value),
+                reinterpret_cast<char*>(&value));
+    table.values[pair] = value;
+    current += record_size;
+  }
+
+  if (table.read_only) {
+    return;
+  }
+
+  if (nb_records > 2 * table.values.size()) {
+    // Most records are outdated values for known pairs, rewrite file
+    // with only the latest ones.
+    std::string buffer(header.begin(), header.end());
+    buffer.reserve(header.size() + table.values.size() * record_size);
+    for (const auto& [p, v] : table.values) {
+      append_record(buffer, p, v);
+    }
+    file.truncate(0);
+    file.write_all(buffer);
+    return;
+  }
+
+  const std::size_t valid_size = header.size() + nb_records * record_size;
+  if (content.size() != valid_size) {
+    // Drop incomplete trailing record, e.g. from an interrupted write.
+    file.truncate(valid_size);
+  }
+}
+
+template <class T>
+void MatrixCache::store(const Table<T>& table,
+                        const std::vector<CoordinatesPair>& pairs) {
+  if (pairs.empty() or table.read_only) {
+    return;
+  }
+
+  LockedFile file(table.file_path, O_WRONLY | O_CREAT | O_APPEND);
+
+  // Other processes may have appended records or been interrupted
+  // mid-write since loading, so check file state under lock.
+  constexpr auto record_size = Table<T>::record_size;
+  std::string buffer;
+  const auto header = get_header<T>();
+  const auto size = file.size();
+  if (size < header.size()) {
+    file.truncate(0);
+    buffer.assign(header.begin(), header.end());
+  } else if ((size - header.size()) % record_size != 0) {
+    file.truncate(size - (size - header.size()) % record_size);
+  }
+
+  buffer.reserve(buffer.size() + pairs.size() * record_size);
+  for (const auto& pair : pairs) {
+    append_record(buffer, pair, table.values.at(pair));
+  }
+
+  file.write_all(buffer);
+}
+
+template <class T>
+void MatrixCache::update(Table<T>& table,
+                         const std::vector<Location>& locs,
+                         const std::vector<Index>& sources,
+                         const std::vector<Index>& destinations,
+                         const Matrix<T>& m,
+                         std::vector<CoordinatesPair>& new_pairs) {
+  for (const auto i : sources) {
+    for (const auto j : destinations) {
+      auto pair = get_pair(locs[i], locs[j]);
+      auto insertion = table.values.emplace(pair, m[i][j]);
+      if (!insertion.second and insertion.first->second != m[i][j]) {
+        // Outdated value, the new record takes precedence upon load.
+        insertion.first->second = m[i][j];
+        insertion.second = true;
+      }
+      if (insertion.second) {
+        new_pairs.push_back(pair);
+      }
+    }
+  }
+}
+
+void MatrixCache::fill_matrix(const std::vector<Location>& locs,
+                              const std::vector<Index>& sources,
+                              const std::vector<Index>& destinations,
+                              Matrix<Cost>& m,
+                              Matrix<Distance>* distances) const {
+  // Fill matrices with known values, spotting unknown pairs and new
+  // sources (resp. destinations), i.e. with no known pair from (resp.
+  // to) them.
+  const std::size_t nb_destinations = destinations.size();
+  std::vector<bool> is_known(sources.size() * nb_destinations, false);
+  std::vector<bool> is_new_source(sources.size(), true);
+  std::vector<bool> is_new_destination(nb_destinations, true);
+
+  for (std::size_t i = 0; i < sources.size(); ++i) {
+    for (std::size_t j = 0; j < nb_destinations; ++j) {
+      const auto pair = get_pair(locs[sources[i]], locs[destinations[j]]);
+      const auto duration = _durations.values.find(pair);
+      if (duration == _durations.values.end()) {
+        continue;
+      }
+      if (distances != nullptr) {
+        const auto distance = _distances.values.find(pair);
+        if (distance == _distances.values.end()) {
+          continue;
+        }
+        (*distances)[sources[i]][destinations[j]] = distance->second;
+      }
+      m[sources[i]][destinations[j]] = duration->second;
+
+      is_known[i * nb_destinations + j] = true;
+      is_new_source[i] = false;
+      is_new_destination[j] = false;
+    }
+  }
+
+  // Unknown pairs are covered by requesting full rows for new sources
+  // and sources with unknown pairs to known destinations, then
+  // columns for new destinations from remaining sources.
+  std::vector<Index> row_sources;
+  std::vector<Index> other_sources;
+  for (std::size_t i = 0; i < sources.size(); ++i) {
+    bool fetch_row = is_new_source[i];
+    for (std::size_t j = 0; !fetch_row and j < nb_destinations; ++j) {
+      fetch_row =
+        !is_new_destination[j] and !is_known[i * nb_destinations + j];
+    }
+    (fetch_row ? row_sources : other_sources).push_back(sources[i]);
+  }
+
+  std::vector<Index> new_destinations;
+  for (std::size_t j = 0; j < nb_destinations; ++j) {
+    if (is_new_destination[j]) {
+      new_destinations.push_back(destinations[j]);
+    }
+  }
+
+  std::vector<CoordinatesPair> new_durations;
+  std::vector<CoordinatesPair> new_distances;
+  auto fetch = [&](const std::vector<Index>& from,
+                   const std::vector<Index>& to) {
+    // Unfound routes are reported by the underlying wrapper.
+    _wrapper->fill_matrix(locs, from, to, m, distances);
+
+    update(_durations, locs, from, to, m, new_durations);
+    if (distances != nullptr) {
+      update(_distances, locs, from, to, *distances, new_distances);
+    }
+  };
+
+  if (2 * row_sources.size() > sources.size()) {
+    // Most rows are required anyway, use a single request.
+    fetch(sources, destinations);
+  } else {
+    if (!row_sources.empty()) {
+      fetch(row_sources, destinations);
+    }
+    if (!other_sources.empty() and !new_destinations.empty()) {
+      fetch(other_sources, new_destinations);
+    }
+  }
+
+  store(_durations, new_durations);
+  if (distances != nullptr) {
+    store(_distances, new_distances);
+  }
+}
+
+void MatrixCache::add_route_info(Route& route) const {
+  _wrapper->add_route_info(route);
+}
+
+} // namespace routing
+} // namespace vroom
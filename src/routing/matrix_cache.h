@@ -0,0 +1,120 @@
+#ifndef MATRIX_CACHE_H
+#define MATRIX_CACHE_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+
+#include "routing/wrapper.h"
+
+namespace vroom {
+namespace routing {
+
+// Wrapper storing durations (and distances if requested) on disk per
+// routing source, profile and coordinates pair. Only rows and columns
+// involving unknown pairs are requested from the underlying routing
+// wrapper, e.g. from and to new locations.
+//
+// Cache files start with a header describing the binary layout,
+// followed by fixed-size records. Appends are done under an exclusive
+// flock so that several processes can share a cache directory. Files
+// that can't be written to are served without being updated.
+class MatrixCache : public Wrapper {
+private:
+  // Source and destination coordinates as lon, lat, lon, lat.
+  using CoordinatesPair = std::array<Coordinate, 4>;
+
+  struct CoordinatesPairHash {
+    std::size_t operator()(const CoordinatesPair& p) const noexcept {
+      std::size_t seed = 0;
+      for (const auto c : p) {
+        seed ^= std::hash<Coordinate>()(c) + 0x9e3779b9 + (seed << 6) +
+                (seed >> 2);
+      }
+      return seed;
+    }
+  };
+
+  using Header = std::array<char, 8>;
+
+  // Values for one kind of matrix (durations as Cost or distances as
+  // Distance), backed by its own file.
+  template <class T> struct Table {
+    static constexpr std::size_t record_size =
+      sizeof(CoordinatesPair) + sizeof(T);
+
+    const std::string file_path;
+    bool read_only;
+    std::unordered_map<CoordinatesPair, T, CoordinatesPairHash> values;
+  };
+
+  const std::unique_ptr<Wrapper> _wrapper;
+
+  // Cache content is updated upon matrix requests.
+  mutable Table<Cost> _durations;
+  mutable Table<Distance> _distances;
+
+  static CoordinatesPair get_pair(const Location& from, const Location& to);
+
+  // Base name for cache files, with characters that are not safe in
+  // file names (e.g. from server host) replaced.
+  static std::string get_file_stem(const std::string& directory,
+                                   const std::string& source,
+                                   const std::string& profile);
+
+  // Magic, format version, types sizes and endianness.
+  template <class T> static Header get_header();
+
+  template <class T>
+  static void
+  append_record(std::string& buffer, const CoordinatesPair& pair, T value);
+
+  // Read all records, dropping an incomplete trailing one from a
+  // writable file. The file is rewritten with one record per pair
+  // when outdated records dominate.
+  template <class T> static void load(Table<T>& table);
+
+  template <class T>
+  static void store(const Table<T>& table,
+                    const std::vector<CoordinatesPair>& pairs);
+
+  // Copy values in m from sources to destinations to table, adding
+  // the pairs to write to disk to new_pairs.
+  template <class T>
+  static void update(Table<T>& table,
+                     const std::vector<Location>& locs,
+                     const std::vector<Index>& sources,
+                     const std::vector<Index>& destinations,
+                     const Matrix<T>& m,
+                     std::vector<CoordinatesPair>& new_pairs);
+
+public:
+  // Source identifies the routing engine and server providing values
+  // (e.g. "osrm_localhost_5000") and is used in cache file names.
+  // Directory has to exist, it is only written to if writable.
+  MatrixCache(std::unique_ptr<Wrapper> wrapper,
+              const std::string& directory,
+              const std::string& source);
+
+  virtual void fill_matrix(const std::vector<Location>& locs,
+                           const std::vector<Index>& sources,
+                           const std::vector<Index>& destinations,
+                           Matrix<Cost>& m,
+                           Matrix<Distance>* distances) const override;
+
+  virtual void add_route_info(Route& route) const override;
+};
+
+} // namespace routing
+} // namespace vroom
+
+#endif
@@ -46,24 +46,48 @@ std::string OrsWrapper::build_query(const std::vector<Location>& locations,
   // Building query for ORS
   std::string query = "POST /ors/v2/" + service + "/" + profile;
 
-  query += " HTTP/1.0\r\n";
+  query += " HTTP/1.1\r\n";
   query += "Accept: */*\r\n";
   query += "Content-Type: application/json\r\n";
   query += "Content-Length: " + std::to_string(body.size()) + "\r\n";
   query += "Host: " + _server.host + ":" + _server.port + "\r\n";
-  query += "Connection: close\r\n";
+  query += "Connection: keep-alive\r\n";
   query += "\r\n" + body;
 
   return query;
 }
 
-void OrsWrapper::parse_response(rapidjson::Document& infos,
-                                const std::string& json_content) const {
-#ifdef NDEBUG
-  infos.Parse(json_content.c_str());
-#else
-  assert(!infos.Parse(json_content.c_str()).HasParseError());
-#endif
+std::string OrsWrapper::matrix_args(unsigned nb_sources,
+                                    unsigned nb_destinations,
+                                    bool distances) const {
+  std::string args;
+
+  if (nb_sources > 0) {
+    args += "\"sources\":[";
+    for (unsigned i = 0; i < nb_sources; ++i) {
+      args += std::to_string(i) + ",";
+    }
+    args.pop_back(); // Remove trailing ','.
+
+    args += "],\"destinations\":[";
+    for (unsigned j = 0; j < nb_destinations; ++j) {
+      args += std::to_string(nb_sources + j) + ",";
+    }
+    args.pop_back(); // Remove trailing ','.
+    args += "]";
+  }
+
+  if (distances) {
+    if (!args.empty()) {
+      args += ",";
+    }
+    args += "\"metrics\":[\"duration\",\"distance\"]";
+  }
+
+  return args;
+}
+
+void OrsWrapper::check_response(const rapidjson::Document& infos) const {
   if (infos.HasMember("error")) {
     throw Exception(ERROR::ROUTING,
                     std::string(infos["error"]["message"].GetString()));
@@ -45,19 +45,43 @@ OsrmRoutedWrapper::build_query(const std::vector<Location>& locations,
   query += " HTTP/1.1\r\n";
   query += "Host: " + _server.host + "\r\n";
   query += "Accept: */*\r\n";
-  query += "Connection: close\r\n\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
 
   return query;
 }
 
-void OsrmRoutedWrapper::parse_response(rapidjson::Document& infos,
-                                       const std::string& json_content) const {
-#ifdef NDEBUG
-  infos.Parse(json_content.c_str());
-#else
-  assert(!infos.Parse(json_content.c_str()).HasParseError());
+std::string OsrmRoutedWrapper::matrix_args(unsigned nb_sources,
+                                           unsigned nb_destinations,
+                                           bool distances) const {
+  std::string args;
+
+  if (nb_sources > 0) {
+    args += "sources=";
+    for (unsigned i = 0; i < nb_sources; ++i) {
+      args += std::to_string(i) + ";";
+    }
+    args.pop_back(); // Remove trailing ';'.
+
+    args += "&destinations=";
+    for (unsigned j = 0; j < nb_destinations; ++j) {
+      args += std::to_string(nb_sources + j) + ";";
+    }
+    args.pop_back(); // Remove trailing ';'.
+  }
+
+  if (distances) {
+    if (!args.empty()) {
+      args += "&";
+    }
+    args += "annotations=duration,distance";
+  }
+
+  return args;
+}
+
+void
+OsrmRoutedWrapper::check_response(const rapidjson::Document& infos) const {
   assert(infos.HasMember("code"));
-#endif
   if (infos["code"] != "Ok") {
     throw Exception(ERROR::ROUTING, std::string(infos["message"].GetString()));
   }
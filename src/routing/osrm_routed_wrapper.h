@@ -21,8 +21,12 @@ private:
                                   const std::string& service,
                                   const std::string& extra_args) const override;
 
-  virtual void parse_response(rapidjson::Document& input,
-                              const std::string& json_content) const override;
+  virtual std::string matrix_args(unsigned nb_sources,
+                                  unsigned nb_destinations,
+                                  bool distances) const override;
+
+  virtual void
+  check_response(const rapidjson::Document& infos) const override;
 
   virtual double
   get_total_distance(const rapidjson::Value& route) const override;
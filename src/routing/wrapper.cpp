@@ -0,0 +1,106 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+
+#include "routing/wrapper.h"
+#include "utils/thread_pool.h"
+
+namespace vroom {
+namespace routing {
+
+void Wrapper::set_matrix_tiling(unsigned max_tile_size, unsigned nb_threads) {
+  _max_tile_size = max_tile_size;
+  _nb_threads = std::max(nb_threads, 1u);
+}
+
+Matrix<Cost> Wrapper::get_matrix(const std::vector<Location>& locs,
+                                 Matrix<Distance>* distances) const {
+  Matrix<Cost> m(locs.size());
+  if (distances != nullptr) {
+    *distances = Matrix<Distance>(locs.size());
+  }
+
+  std::vector<Index> ranks(locs.size());
+  std::iota(ranks.begin(), ranks.end(), 0);
+  fill_matrix(locs, ranks, ranks, m, distances);
+
+  return m;
+}
+
+void Wrapper::fill_tiled_matrix(const std::vector<Location>& locs,
+                                const std::vector<Index>& sources,
+                                const std::vector<Index>& destinations,
+                                Matrix<Cost>& m,
+                                const TileFiller& fill_tile) const {
+  assert(!sources.empty() and !destinations.empty());
+  assert(m.size() == locs.size());
+
+  std::vector<unsigned> nb_unfound_from_loc(locs.size(), 0);
+  std::vector<unsigned> nb_unfound_to_loc(locs.size(), 0);
+
+  auto nb_blocks = [&](const std::vector<Index>& ranks) {
+    return (_max_tile_size == 0)
+             ? 1
+             : (ranks.size() + _max_tile_size - 1) / _max_tile_size;
+  };
+  const std::size_t nb_source_blocks = nb_blocks(sources);
+  const std::size_t nb_destination_blocks = nb_blocks(destinations);
+
+  auto block_ranks = [&](const std::vector<Index>& ranks, std::size_t b) {
+    if (_max_tile_size == 0) {
+      return ranks;
+    }
+    const std::size_t first = b * _max_tile_size;
+    const std::size_t last =
+      std::min<std::size_t>(first + _max_tile_size, ranks.size());
+    return std::vector<Index>(ranks.begin() + first, ranks.begin() + last);
+  };
+
+  // Tiles write to distinct matrix cells, only merging unfound routes
+  // counts requires a lock.
+  std::mutex unfound_mutex;
+
+  auto run_tile = [&](std::size_t tile_rank) {
+    const auto tile_sources =
+      block_ranks(sources, tile_rank / nb_destination_blocks);
+    const auto tile_destinations =
+      block_ranks(destinations, tile_rank % nb_destination_blocks);
+
+    std::vector<unsigned> nb_unfound_from_source(tile_sources.size(), 0);
+    std::vector<unsigned> nb_unfound_to_destination(tile_destinations.size(),
+                                                    0);
+
+    fill_tile(tile_sources,
+              tile_destinations,
+              m,
+              nb_unfound_from_source,
+              nb_unfound_to_destination);
+
+    std::scoped_lock<std::mutex> lock(unfound_mutex);
+    for (std::size_t i = 0; i < tile_sources.size(); ++i) {
+      nb_unfound_from_loc[tile_sources[i]] += nb_unfound_from_source[i];
+    }
+    for (std::size_t j = 0; j < tile_destinations.size(); ++j) {
+      nb_unfound_to_loc[tile_destinations[j]] += nb_unfound_to_destination[j];
+    }
+  };
+
+  utils::ThreadPool::shared().parallel_for(nb_source_blocks *
+                                             nb_destination_blocks,
+                                           _nb_threads,
+                                           run_tile);
+
+  check_unfound(locs, nb_unfound_from_loc, nb_unfound_to_loc);
+}
+
+} // namespace routing
+} // namespace vroom
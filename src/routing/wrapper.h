@@ -10,6 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <functional>
 #include <vector>
 
 #include "structures/generic/matrix.h"
@@ -25,17 +26,57 @@ class Wrapper {
 public:
   std::string profile;
 
-  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs) const = 0;
+  // Compute durations matrix for locs. If distances is not null, it
+  // is filled with the distances matrix from the same request(s).
+  Matrix<Cost> get_matrix(const std::vector<Location>& locs,
+                          Matrix<Distance>* distances) const;
+
+  // Fill m (and distances if not null), both already sized for locs,
+  // with values from locations at ranks in sources to locations at
+  // ranks in destinations.
+  virtual void fill_matrix(const std::vector<Location>& locs,
+                           const std::vector<Index>& sources,
+                           const std::vector<Index>& destinations,
+                           Matrix<Cost>& m,
+                           Matrix<Distance>* distances) const = 0;
 
   virtual void add_route_info(Route& route) const = 0;
 
+  // Split matrix requests in tiles with at most max_tile_size sources
+  // and destinations (0 for a single request), issuing up to
+  // nb_threads tile requests concurrently.
+  void set_matrix_tiling(unsigned max_tile_size, unsigned nb_threads);
+
   virtual ~Wrapper() {
   }
 
 protected:
+  unsigned _max_tile_size{0};
+  unsigned _nb_threads{1};
+
   Wrapper(const std::string& profile) : profile(profile) {
   }
 
+  // Fill m with costs from locations at ranks in sources to locations
+  // at ranks in destinations. Unfound routes are counted per source
+  // (resp. destination) in the two last vectors, in the same order as
+  // sources (resp. destinations).
+  using TileFiller =
+    std::function<void(const std::vector<Index>& sources,
+                       const std::vector<Index>& destinations,
+                       Matrix<Cost>& m,
+                       std::vector<unsigned>& nb_unfound_from_source,
+                       std::vector<unsigned>& nb_unfound_to_destination)>;
+
+  // Fill m from locations at ranks in sources to locations at ranks
+  // in destinations using tiles computed with fill_tile, then check
+  // for unfound routes across all tiles.
+  void fill_tiled_matrix(const std::vector<Location>& locs,
+                         const std::vector<Index>& sources,
+                         const std::vector<Index>& destinations,
+                         Matrix<Cost>& m,
+                         const TileFiller& fill_tile) const;
+
   static Cost round_cost(double value) {
     return static_cast<Cost>(value + 0.5);
   }
@@ -18,7 +18,14 @@ const unsigned CLArgs::max_exploration_level = 5;
 
 // Default values.
 CLArgs::CLArgs()
-  : geometry(false), router(ROUTER::OSRM), nb_threads(4), exploration_level(5) {
+  : distances(false),
+    geometry(false),
+    router(ROUTER::OSRM),
+    seed_pruning(false),
+    nb_neighbours(0),
+    matrix_tile_size(0),
+    nb_threads(4),
+    exploration_level(5) {
 }
 
 void update_host(Servers& servers, const std::string& value) {
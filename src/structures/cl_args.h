@@ -25,12 +25,18 @@ using Servers = std::unordered_map<std::string, Server>;
 struct CLArgs {
   // Listing command-line options.
   Servers servers;                           // -a and -p
+  std::string matrix_cache_dir;              // -c
+  bool distances;                            // -d
   std::vector<HeuristicParameters> h_params; // -e
   bool geometry;                             // -g
   std::string input_file;                    // -i
+  Timeout timeout;                           // -l
   std::string output_file;                   // -o
   ROUTER router;                             // -r
+  bool seed_pruning;                         // -s
   std::string input;                         // cl arg
+  unsigned nb_neighbours;                    // -k
+  unsigned matrix_tile_size;                 // -m
   unsigned nb_threads;                       // -t
   unsigned exploration_level;                // -x
 
@@ -0,0 +1,72 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace vroom {
+
+// Growable bitset with the first 64 bits stored inline, which is
+// enough for most sets without allocating. Set operations are written
+// as branchless loops over words so the compiler can vectorize them.
+class Bitset {
+private:
+  static constexpr std::size_t WORD_SIZE = 64;
+
+  uint64_t _first_word;
+  std::vector<uint64_t> _other_words;
+
+public:
+  Bitset() : _first_word(0) {
+  }
+
+  void set(std::size_t rank) {
+    const uint64_t mask = uint64_t(1) << (rank % WORD_SIZE);
+    const std::size_t word_rank = rank / WORD_SIZE;
+    if (word_rank == 0) {
+      _first_word |= mask;
+    } else {
+      if (_other_words.size() < word_rank) {
+        _other_words.resize(word_rank, 0);
+      }
+      _other_words[word_rank - 1] |= mask;
+    }
+  }
+
+  bool is_subset_of(const Bitset& other) const {
+    uint64_t extra = _first_word & ~other._first_word;
+    const std::size_t common_size =
+      std::min(_other_words.size(), other._other_words.size());
+    for (std::size_t i = 0; i < common_size; ++i) {
+      extra |= _other_words[i] & ~other._other_words[i];
+    }
+    for (std::size_t i = common_size; i < _other_words.size(); ++i) {
+      extra |= _other_words[i];
+    }
+    return extra == 0;
+  }
+
+  bool intersects(const Bitset& other) const {
+    uint64_t common = _first_word & other._first_word;
+    const std::size_t common_size =
+      std::min(_other_words.size(), other._other_words.size());
+    for (std::size_t i = 0; i < common_size; ++i) {
+      common |= _other_words[i] & other._other_words[i];
+    }
+    return common != 0;
+  }
+};
+
+} // namespace vroom
+
+#endif
@@ -7,38 +7,51 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cassert>
+
 #include "structures/generic/matrix.h"
 
 namespace vroom {
 
-template <class T> Line<T>::Line(std::size_t n) : parent(n) {
-}
-
-template <class T> Line<T>::Line(std::initializer_list<T> l) : parent(l) {
+template <class T> std::size_t Matrix<T>::stride_for(std::size_t n) {
+  constexpr std::size_t per_cache_line =
+    (CACHE_LINE_SIZE >= sizeof(T)) ? CACHE_LINE_SIZE / sizeof(T) : 1;
+  return ((n + per_cache_line - 1) / per_cache_line) * per_cache_line;
 }
 
-template <class T> Matrix<T>::Matrix(std::size_t n) : parent(n, Line<T>(n)) {
+template <class T>
+Matrix<T>::Matrix(std::size_t n)
+  : _size(n), _stride(stride_for(n)), _data(_size * _stride) {
 }
 
 template <class T> Matrix<T>::Matrix() : Matrix(0) {
 }
 
 template <class T>
-Matrix<T>::Matrix(std::initializer_list<Line<T>> l) : parent(l) {
+Matrix<T>::Matrix(std::initializer_list<std::initializer_list<T>> l)
+  : Matrix(l.size()) {
+  std::size_t i = 0;
+  for (const auto& line : l) {
+    assert(line.size() == _size);
+    std::copy(line.begin(), line.end(), (*this)[i]);
+    ++i;
+  }
 }
 
 template <class T>
 Matrix<T> Matrix<T>::get_sub_matrix(const std::vector<Index>& indices) const {
   Matrix<T> sub_matrix(indices.size());
   for (std::size_t i = 0; i < indices.size(); ++i) {
+    const T* origin_line = (*this)[indices[i]];
+    T* sub_line = sub_matrix[i];
     for (std::size_t j = 0; j < indices.size(); ++j) {
-      sub_matrix[i][j] = (*this)[indices[i]][indices[j]];
+      sub_line[j] = origin_line[indices[j]];
     }
   }
   return sub_matrix;
 }
 
-template class Line<Cost>;
 template class Matrix<Cost>;
 
 } // namespace vroom
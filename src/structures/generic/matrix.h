@@ -11,38 +11,74 @@ All rights reserved (see LICENSE).
 */
 
 #include <initializer_list>
+#include <new>
 #include <vector>
 
 #include "structures/typedefs.h"
 
 namespace vroom {
 
-template <class T> class Line : private std::vector<T> {
+// Allocator used to have matrix lines start on a cache line boundary.
+template <class T> struct CacheAlignedAllocator {
+  using value_type = T;
 
-  using parent = std::vector<T>;
+  CacheAlignedAllocator() = default;
 
-public:
-  using parent::size;
-  using parent::operator[];
+  template <class U>
+  constexpr CacheAlignedAllocator(const CacheAlignedAllocator<U>&) noexcept {
+  }
 
-  Line(std::size_t n);
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+      ::operator new(n * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+  }
 
-  Line(std::initializer_list<T> l);
+  void deallocate(T* p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t(CACHE_LINE_SIZE));
+  }
 };
 
-template <class T> class Matrix : private std::vector<Line<T>> {
+template <class T, class U>
+bool operator==(const CacheAlignedAllocator<T>&,
+                const CacheAlignedAllocator<U>&) {
+  return true;
+}
 
-  using parent = std::vector<Line<T>>;
+template <class T, class U>
+bool operator!=(const CacheAlignedAllocator<T>&,
+                const CacheAlignedAllocator<U>&) {
+  return false;
+}
 
-public:
-  using parent::size;
-  using parent::operator[];
+// Square matrix stored row-major in a single contiguous buffer. Each
+// line is padded up to a multiple of the cache line size so that
+// m[i] always starts on a cache line boundary.
+template <class T> class Matrix {
+
+  std::size_t _size;
+  std::size_t _stride;
+  std::vector<T, CacheAlignedAllocator<T>> _data;
+
+  static std::size_t stride_for(std::size_t n);
 
+public:
   Matrix();
 
   Matrix(std::size_t n);
 
-  Matrix(std::initializer_list<Line<T>> l);
+  Matrix(std::initializer_list<std::initializer_list<T>> l);
+
+  std::size_t size() const {
+    return _size;
+  }
+
+  T* operator[](std::size_t i) {
+    return _data.data() + i * _stride;
+  }
+
+  const T* operator[](std::size_t i) const {
+    return _data.data() + i * _stride;
+  }
 
   Matrix<T> get_sub_matrix(const std::vector<Index>& indices) const;
 };
@@ -11,8 +11,10 @@ All rights reserved (see LICENSE).
 */
 
 #include <array>
+#include <chrono>
 #include <limits>
 #include <list>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -21,7 +23,11 @@ namespace vroom {
 
 // To easily differentiate variable types.
 using Id = uint64_t;
+#if USE_LARGE_INDEX
+using Index = uint32_t;
+#else
 using Index = uint16_t;
+#endif
 using Cost = uint32_t;
 using Gain = int64_t;
 using Distance = uint32_t;
@@ -35,6 +41,9 @@ using Priority = uint32_t;
 using Coordinates = std::array<Coordinate, 2>;
 using OptionalCoordinates = std::optional<Coordinates>;
 using Skills = std::unordered_set<Skill>;
+using TimePoint = std::chrono::high_resolution_clock::time_point;
+using Timeout = std::optional<std::chrono::milliseconds>;
+using Deadline = std::optional<TimePoint>;
 
 // Setting max value would cause trouble with further additions.
 constexpr Cost INFINITE_COST = 3 * (std::numeric_limits<Cost>::max() / 4);
@@ -43,6 +52,13 @@ const std::string DEFAULT_PROFILE = "car";
 
 constexpr Priority MAX_PRIORITY = 100;
 
+// Upper bound for the number of jobs, vehicles and matrix locations
+// given the index width.
+constexpr std::size_t MAX_INDEX_SIZE = std::numeric_limits<Index>::max();
+
+// Used to align contiguous storage on cache lines.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
 // Available routing engines.
 enum class ROUTER { OSRM, LIBOSRM, ORS };
 
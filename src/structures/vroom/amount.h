@@ -10,6 +10,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <vector>
 
@@ -54,13 +56,12 @@ bool operator<<(const AmountExpression<E1>& lhs,
 template <typename E1, typename E2>
 bool operator<=(const AmountExpression<E1>& lhs,
                 const AmountExpression<E2>& rhs) {
-  bool is_inf = true;
   assert(lhs.size() == rhs.size());
+  // No early exit, amount sizes are small and a branchless loop is
+  // easier to vectorize.
+  bool is_inf = true;
   for (std::size_t i = 0; i < lhs.size(); ++i) {
-    if (lhs[i] > rhs[i]) {
-      is_inf = false;
-      break;
-    }
+    is_inf &= (lhs[i] <= rhs[i]);
   }
 
   return is_inf;
@@ -69,67 +70,205 @@ bool operator<=(const AmountExpression<E1>& lhs,
 template <typename E1, typename E2>
 bool operator==(const AmountExpression<E1>& lhs,
                 const AmountExpression<E2>& rhs) {
-  bool is_equal = true;
   assert(lhs.size() == rhs.size());
+  bool is_equal = true;
   for (std::size_t i = 0; i < lhs.size(); ++i) {
-    if (lhs[i] != rhs[i]) {
-      is_equal = false;
-      break;
-    }
+    is_equal &= (lhs[i] == rhs[i]);
   }
 
   return is_equal;
 }
 
 class Amount : public AmountExpression<Amount> {
+  // Values are stored inline for usual amount sizes in order to avoid
+  // heap allocations when copying amounts around. Larger amounts fall
+  // back to heap storage.
+  static constexpr std::size_t INLINE_SIZE = 4;
+
+  std::size_t _size;
+  std::array<Capacity, INLINE_SIZE> _inline_elems;
+  std::vector<Capacity> _heap_elems;
 
-  std::vector<Capacity> elems;
+  bool is_inline() const {
+    return _size <= INLINE_SIZE;
+  }
 
 public:
-  Amount() = default;
+  Amount() : _size(0), _inline_elems() {
+  }
 
-  Amount(std::size_t size) : elems(size, 0){};
+  Amount(std::size_t size) : _size(size), _inline_elems() {
+    if (!is_inline()) {
+      _heap_elems.resize(size, 0);
+    }
+  };
 
-  template <typename E> Amount(const AmountExpression<E>& u) {
-    elems.resize(u.size());
-    for (std::size_t i = 0; i < u.size(); ++i) {
+  template <typename E>
+  Amount(const AmountExpression<E>& u) : Amount(u.size()) {
+    Capacity* elems = data();
+    for (std::size_t i = 0; i < _size; ++i) {
       elems[i] = u[i];
     }
   }
 
   void push_back(Capacity c) {
-    elems.push_back(c);
+    if (_size < INLINE_SIZE) {
+      _inline_elems[_size] = c;
+    } else {
+      if (_size == INLINE_SIZE) {
+        // Switching to heap storage.
+        _heap_elems.assign(_inline_elems.begin(), _inline_elems.end());
+      }
+      _heap_elems.push_back(c);
+    }
+    ++_size;
   };
 
+  Capacity* data() {
+    return is_inline() ? _inline_elems.data() : _heap_elems.data();
+  }
+
+  const Capacity* data() const {
+    return is_inline() ? _inline_elems.data() : _heap_elems.data();
+  }
+
   Capacity operator[](std::size_t i) const {
-    return elems[i];
+    return data()[i];
   };
 
   Capacity& operator[](std::size_t i) {
-    return elems[i];
+    return data()[i];
   };
 
   std::size_t size() const {
-    return elems.size();
+    return _size;
   };
 
   Amount& operator+=(const Amount& rhs) {
     assert(this->size() == rhs.size());
-    for (std::size_t i = 0; i < this->size(); ++i) {
-      (*this)[i] += rhs[i];
+    Capacity* elems = data();
+    const Capacity* rhs_elems = rhs.data();
+    for (std::size_t i = 0; i < _size; ++i) {
+      elems[i] += rhs_elems[i];
     }
     return *this;
   }
 
   Amount& operator-=(const Amount& rhs) {
     assert(this->size() == rhs.size());
-    for (std::size_t i = 0; i < this->size(); ++i) {
-      (*this)[i] -= rhs[i];
+    Capacity* elems = data();
+    const Capacity* rhs_elems = rhs.data();
+    for (std::size_t i = 0; i < _size; ++i) {
+      elems[i] -= rhs_elems[i];
     }
     return *this;
   }
 };
 
+// Read-only access to an amount stored in external contiguous memory.
+class AmountView : public AmountExpression<AmountView> {
+  const Capacity* _elems;
+  std::size_t _size;
+
+public:
+  AmountView(const Capacity* elems, std::size_t size)
+    : _elems(elems), _size(size) {
+  }
+
+  AmountView(const Amount& amount) : AmountView(amount.data(), amount.size()) {
+  }
+
+  const Capacity* data() const {
+    return _elems;
+  }
+
+  Capacity operator[](std::size_t i) const {
+    return _elems[i];
+  };
+
+  std::size_t size() const {
+    return _size;
+  };
+};
+
+// Sequence of amounts of identical size stored in a single buffer,
+// one row of contiguous values per amount. The buffer is only ever
+// grown so resizing it again does not reallocate in most cases.
+class AmountArray {
+  std::size_t _nb_amounts;
+  std::size_t _amount_size;
+  std::vector<Capacity> _elems;
+
+public:
+  AmountArray() : _nb_amounts(0), _amount_size(0) {
+  }
+
+  // Values are not preserved when resizing.
+  void resize(std::size_t nb_amounts, std::size_t amount_size) {
+    _nb_amounts = nb_amounts;
+    _amount_size = amount_size;
+    if (_elems.size() < nb_amounts * amount_size) {
+      _elems.resize(nb_amounts * amount_size);
+    }
+  }
+
+  // Replace nb_old rows starting at first with nb_new rows, shifting
+  // following rows accordingly. Values in new rows are unspecified.
+  void replace_rows(std::size_t first, std::size_t nb_old, std::size_t nb_new) {
+    assert(first + nb_old <= _nb_amounts);
+    const std::size_t new_nb_amounts = _nb_amounts - nb_old + nb_new;
+    if (_elems.size() < new_nb_amounts * _amount_size) {
+      _elems.resize(new_nb_amounts * _amount_size);
+    }
+
+    auto tail_begin = _elems.begin() + (first + nb_old) * _amount_size;
+    auto tail_end = _elems.begin() + _nb_amounts * _amount_size;
+    if (nb_old < nb_new) {
+      std::copy_backward(tail_begin,
+                         tail_end,
+                         tail_end + (nb_new - nb_old) * _amount_size);
+    } else {
+      std::copy(tail_begin,
+                tail_end,
+                _elems.begin() + (first + nb_new) * _amount_size);
+    }
+    _nb_amounts = new_nb_amounts;
+  }
+
+  void set_zero() {
+    std::fill(_elems.begin(), _elems.begin() + _nb_amounts * _amount_size, 0);
+  }
+
+  std::size_t size() const {
+    return _nb_amounts;
+  }
+
+  Capacity* row(std::size_t i) {
+    return _elems.data() + i * _amount_size;
+  }
+
+  const Capacity* row(std::size_t i) const {
+    return _elems.data() + i * _amount_size;
+  }
+
+  AmountView operator[](std::size_t i) const {
+    return AmountView(row(i), _amount_size);
+  }
+
+  AmountView back() const {
+    return (*this)[_nb_amounts - 1];
+  }
+
+  template <typename E>
+  void assign(std::size_t i, const AmountExpression<E>& u) {
+    assert(u.size() == _amount_size);
+    Capacity* elems = row(i);
+    for (std::size_t r = 0; r < _amount_size; ++r) {
+      elems[r] = u[r];
+    }
+  }
+};
+
 template <typename E1, typename E2>
 class AmountSum : public AmountExpression<AmountSum<E1, E2>> {
   const E1& lhs;
@@ -6,7 +6,9 @@ Copyright (c) 2015-2020, Julien Coupey.
 All rights reserved (see LICENSE).
 
 */
+#include <algorithm>
 #include <array>
+#include <limits>
 
 #include "problems/cvrp/cvrp.h"
 #include "problems/tsp/tsp.h"
@@ -15,19 +17,54 @@ All rights reserved (see LICENSE).
 #include "structures/vroom/input/input.h"
 #include "utils/exception.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 
+inline bool have_same_tws(const TimeWindow& lhs, const TimeWindow& rhs) {
+  return lhs.start == rhs.start and lhs.end == rhs.end;
+}
+
+inline bool have_same_profile(const Vehicle& lhs, const Vehicle& rhs) {
+  if (lhs.has_start() != rhs.has_start() or lhs.has_end() != rhs.has_end() or
+      (lhs.has_start() and
+       lhs.start.value().index() != rhs.start.value().index()) or
+      (lhs.has_end() and lhs.end.value().index() != rhs.end.value().index()) or
+      !(lhs.capacity == rhs.capacity) or !have_same_tws(lhs.tw, rhs.tw) or
+      lhs.breaks.size() != rhs.breaks.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < lhs.breaks.size(); ++i) {
+    const auto& lhs_b = lhs.breaks[i];
+    const auto& rhs_b = rhs.breaks[i];
+    if (lhs_b.service != rhs_b.service or
+        !std::equal(lhs_b.tws.begin(),
+                    lhs_b.tws.end(),
+                    rhs_b.tws.begin(),
+                    rhs_b.tws.end(),
+                    have_same_tws)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 Input::Input(unsigned amount_size)
   : _start_loading(std::chrono::high_resolution_clock::now()),
     _no_addition_yet(true),
     _has_TW(false),
     _homogeneous_locations(true),
     _geometry(false),
+    _distances(false),
+    _seed_pruning(false),
     _has_jobs(false),
     _has_shipments(false),
     _has_custom_matrix(false),
     _all_locations_have_coords(true),
+    _nb_neighbours(0),
+    _has_granular_neighbourhoods(false),
     _amount_size(amount_size),
     _zero(_amount_size) {
 }
@@ -36,11 +73,44 @@ void Input::set_geometry(bool geometry) {
   _geometry = geometry;
 }
 
+void Input::set_distances(bool distances) {
+  _distances = distances;
+}
+
+void Input::set_seed_pruning(bool seed_pruning) {
+  _seed_pruning = seed_pruning;
+}
+
+void Input::set_nb_neighbours(unsigned nb_neighbours) {
+  _nb_neighbours = nb_neighbours;
+}
+
 void Input::set_routing(std::unique_ptr<routing::Wrapper> routing_wrapper) {
   _routing_wrapper = std::move(routing_wrapper);
 }
 
+void Input::check_index_range(std::size_t size,
+                              const std::string& type) const {
+  if (size > MAX_INDEX_SIZE) {
+    throw Exception(ERROR::INPUT,
+                    "Too many " + type + ", max allowed is " +
+                      std::to_string(MAX_INDEX_SIZE) +
+                      " (build with LARGE_INDEX=1 for larger instances).");
+  }
+}
+
+Bitset Input::get_skills_bitset(const Skills& skills) {
+  Bitset bitset;
+  for (const auto s : skills) {
+    auto rank = _skill_ranks.emplace(s, _skill_ranks.size()).first->second;
+    bitset.set(rank);
+  }
+  return bitset;
+}
+
 void Input::check_job(Job& job) {
+  check_index_range(jobs.size(), "jobs");
+
   // Ensure delivery size consistency.
   const auto& delivery_size = job.delivery.size();
   if (delivery_size != _amount_size) {
@@ -68,6 +138,7 @@ void Input::check_job(Job& job) {
       throw Exception(ERROR::INPUT, "Missing skills.");
     }
   }
+  _jobs_skills.push_back(get_skills_bitset(job.skills));
 
   // Check for time-windows.
   _has_TW |= (!(job.tws.size() == 1) or !job.tws[0].is_default());
@@ -81,6 +152,7 @@ void Input::check_job(Job& job) {
       job.location.set_index(search->second);
     } else {
       // Append new location and store corresponding index.
+      check_index_range(_locations.size() + 1, "locations");
       auto new_index = _locations.size();
       job.location.set_index(new_index);
       _locations.push_back(job.location);
@@ -109,14 +181,9 @@ void Input::add_shipment(const Job& pickup, const Job& delivery) {
   if (!(pickup.pickup == delivery.delivery)) {
     throw Exception(ERROR::INPUT, "Inconsistent shipment amount.");
   }
-  if (pickup.skills.size() != delivery.skills.size()) {
+  if (pickup.skills != delivery.skills) {
     throw Exception(ERROR::INPUT, "Inconsistent shipment skills.");
   }
-  for (const auto s : pickup.skills) {
-    if (delivery.skills.find(s) == delivery.skills.end()) {
-      throw Exception(ERROR::INPUT, "Inconsistent shipment skills.");
-    }
-  }
 
   if (pickup.type != JOB_TYPE::PICKUP) {
     throw Exception(ERROR::INPUT, "Wrong pickup type.");
@@ -134,6 +201,7 @@ void Input::add_shipment(const Job& pickup, const Job& delivery) {
 
 void Input::add_vehicle(const Vehicle& vehicle) {
   vehicles.push_back(vehicle);
+  check_index_range(vehicles.size(), "vehicles");
 
   auto& current_v = vehicles.back();
 
@@ -155,6 +223,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
       throw Exception(ERROR::INPUT, "Missing skills.");
     }
   }
+  _vehicles_skills.push_back(get_skills_bitset(current_v.skills));
 
   // Check for time-windows.
   _has_TW = _has_TW || !vehicle.tw.is_default();
@@ -175,6 +244,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
         start_loc.set_index(search->second);
       } else {
         // Append new location and store corresponding index.
+        check_index_range(_locations.size() + 1, "locations");
         auto new_index = _locations.size();
         start_loc.set_index(new_index);
         _locations.push_back(start_loc);
@@ -200,6 +270,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
         end_loc.set_index(search->second);
       } else {
         // Append new location and store corresponding index.
+        check_index_range(_locations.size() + 1, "locations");
         auto new_index = _locations.size();
         end_loc.set_index(new_index);
         _locations.push_back(end_loc);
@@ -221,6 +292,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
 }
 
 void Input::set_matrix(Matrix<Cost>&& m) {
+  check_index_range(m.size(), "matrix locations");
   _has_custom_matrix = true;
   _matrix = std::move(m);
 }
@@ -302,39 +374,52 @@ void Input::set_compatibility() {
                                 std::vector<unsigned char>(jobs.size(), true));
   if (_has_skills) {
     for (std::size_t v = 0; v < vehicles.size(); ++v) {
-      const auto& v_skills = vehicles[v].skills;
-      assert(!v_skills.empty());
-
+      assert(!vehicles[v].skills.empty());
       for (std::size_t j = 0; j < jobs.size(); ++j) {
-        bool is_compatible = true;
         assert(!jobs[j].skills.empty());
-        for (const auto& s : jobs[j].skills) {
-          if (v_skills.find(s) == v_skills.end()) {
-            is_compatible = false;
-            break;
-          }
-        }
-        _vehicle_to_job_compatibility[v][j] = is_compatible;
+        _vehicle_to_job_compatibility[v][j] =
+          _jobs_skills[j].is_subset_of(_vehicles_skills[v]);
       }
     }
   }
 
+  // Vehicles with same start, end, capacity, time window and breaks
+  // behave the same for the checks below, so they are only performed
+  // once per distinct vehicle profile.
+  std::vector<std::vector<Index>> profiles;
+  for (Index v = 0; v < vehicles.size(); ++v) {
+    auto profile =
+      std::find_if(profiles.begin(), profiles.end(), [&](const auto& p) {
+        return have_same_profile(vehicles[p.front()], vehicles[v]);
+      });
+    if (profile == profiles.end()) {
+      profiles.push_back({v});
+    } else {
+      profile->push_back(v);
+    }
+  }
+
   // Derive potential extra incompatibilities : jobs or shipments with
   // amount that does not fit into vehicle or that cannot be added to
   // an empty route for vehicle based on the timing constraints (when
   // they apply).
-  for (std::size_t v = 0; v < vehicles.size(); ++v) {
-    TWRoute empty_route(*this, v);
+  for (const auto& profile : profiles) {
+    TWRoute empty_route(*this, profile.front());
     for (Index j = 0; j < jobs.size(); ++j) {
-      if (_vehicle_to_job_compatibility[v][j]) {
+      bool is_shipment_pickup = (jobs[j].type == JOB_TYPE::PICKUP);
+
+      bool skills_ok_for_profile =
+        std::any_of(profile.begin(), profile.end(), [&](const auto v) {
+          return _vehicle_to_job_compatibility[v][j];
+        });
+
+      if (skills_ok_for_profile) {
         bool is_compatible =
           empty_route.is_valid_addition_for_capacity(*this,
                                                      jobs[j].pickup,
                                                      jobs[j].delivery,
                                                      0);
 
-        bool is_shipment_pickup = (jobs[j].type == JOB_TYPE::PICKUP);
-
         if (is_compatible and _has_TW) {
           if (jobs[j].type == JOB_TYPE::SINGLE) {
             is_compatible = is_compatible &&
@@ -351,13 +436,31 @@ void Input::set_compatibility() {
           }
         }
 
-        _vehicle_to_job_compatibility[v][j] = is_compatible;
-        if (is_shipment_pickup) {
-          // Skipping matching delivery which is next in line in jobs.
-          _vehicle_to_job_compatibility[v][j + 1] = is_compatible;
-          ++j;
+        for (const auto v : profile) {
+          if (_vehicle_to_job_compatibility[v][j]) {
+            _vehicle_to_job_compatibility[v][j] = is_compatible;
+            if (is_shipment_pickup) {
+              _vehicle_to_job_compatibility[v][j + 1] = is_compatible;
+            }
+          }
         }
       }
+
+      if (is_shipment_pickup) {
+        // Skipping matching delivery which is next in line in jobs.
+        ++j;
+      }
+    }
+  }
+
+  // Two vehicles are compatible if they share at least one compatible
+  // job.
+  std::vector<Bitset> compatible_jobs(vehicles.size());
+  for (std::size_t v = 0; v < vehicles.size(); ++v) {
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+      if (_vehicle_to_job_compatibility[v][j]) {
+        compatible_jobs[v].set(j);
+      }
     }
   }
 
@@ -367,16 +470,76 @@ void Input::set_compatibility() {
   for (std::size_t v1 = 0; v1 < vehicles.size(); ++v1) {
     _vehicle_to_vehicle_compatibility[v1][v1] = true;
     for (std::size_t v2 = v1 + 1; v2 < vehicles.size(); ++v2) {
-      for (std::size_t j = 0; j < jobs.size(); ++j) {
-        if (_vehicle_to_job_compatibility[v1][j] and
-            _vehicle_to_job_compatibility[v2][j]) {
-          _vehicle_to_vehicle_compatibility[v1][v2] = true;
-          _vehicle_to_vehicle_compatibility[v2][v1] = true;
-          break;
-        }
+      if (compatible_jobs[v1].intersects(compatible_jobs[v2])) {
+        _vehicle_to_vehicle_compatibility[v1][v2] = true;
+        _vehicle_to_vehicle_compatibility[v2][v1] = true;
+      }
+    }
+  }
+}
+
+void Input::set_neighbourhoods() {
+  // Restricting local search moves only makes sense if each job has
+  // more candidates than the wanted number of neighbours.
+  _has_granular_neighbourhoods =
+    (_nb_neighbours > 0) and (_nb_neighbours + 1 < jobs.size());
+  if (!_has_granular_neighbourhoods) {
+    return;
+  }
+
+  // Jobs can only be neighbours in a route if they share at least
+  // one compatible vehicle, so other jobs are not accounted for.
+  std::vector<Bitset> compatible_vehicles(jobs.size());
+  for (std::size_t v = 0; v < vehicles.size(); ++v) {
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+      if (_vehicle_to_job_compatibility[v][j]) {
+        compatible_vehicles[j].set(v);
       }
     }
   }
+
+  // Store the cost of the _nb_neighbours-th shortest edge leaving
+  // (resp. reaching) each job so that checking whether an edge is
+  // short is a constant time operation.
+  _max_out_edge_costs.resize(jobs.size());
+  _max_in_edge_costs.resize(jobs.size());
+
+  std::vector<Cost> out_costs;
+  std::vector<Cost> in_costs;
+  out_costs.reserve(jobs.size() - 1);
+  in_costs.reserve(jobs.size() - 1);
+
+  const auto nth = _nb_neighbours - 1;
+
+  for (std::size_t j = 0; j < jobs.size(); ++j) {
+    const auto j_index = jobs[j].index();
+    out_costs.clear();
+    in_costs.clear();
+    for (std::size_t other = 0; other < jobs.size(); ++other) {
+      if (other == j or
+          !compatible_vehicles[j].intersects(compatible_vehicles[other])) {
+        continue;
+      }
+      const auto other_index = jobs[other].index();
+      out_costs.push_back(_matrix[j_index][other_index]);
+      in_costs.push_back(_matrix[other_index][j_index]);
+    }
+
+    if (out_costs.size() <= nth) {
+      // Not enough compatible jobs, all edges are considered short.
+      _max_out_edge_costs[j] = std::numeric_limits<Cost>::max();
+      _max_in_edge_costs[j] = std::numeric_limits<Cost>::max();
+      continue;
+    }
+
+    std::nth_element(out_costs.begin(),
+                     out_costs.begin() + nth,
+                     out_costs.end());
+    _max_out_edge_costs[j] = out_costs[nth];
+
+    std::nth_element(in_costs.begin(), in_costs.begin() + nth, in_costs.end());
+    _max_in_edge_costs[j] = in_costs[nth];
+  }
 }
 
 std::unique_ptr<VRP> Input::get_problem() const {
@@ -389,19 +552,34 @@ std::unique_ptr<VRP> Input::get_problem() const {
 
 Solution Input::solve(unsigned exploration_level,
                       unsigned nb_thread,
-                      const std::vector<HeuristicParameters>& h_param) {
+                      const std::vector<HeuristicParameters>& h_param,
+                      const Timeout& timeout) {
   if (_geometry and !_all_locations_have_coords) {
     // Early abort when info is required with missing coordinates.
     throw Exception(ERROR::INPUT,
                     "Route geometry request with missing coordinates.");
   }
 
+  if (_distances and _has_custom_matrix) {
+    throw Exception(ERROR::INPUT, "Distances request with custom matrix.");
+  }
+
   if (!_has_custom_matrix) {
+    // Distances are retrieved along with durations unless route
+    // geometry queries provide them anyway.
+    const bool get_distances = _distances and !_geometry;
+
     if (_locations.size() == 1) {
       _matrix = Matrix<Cost>({{0}});
+      if (get_distances) {
+        _distance_matrix = Matrix<Distance>({{0}});
+      }
     } else {
       assert(_routing_wrapper);
-      _matrix = _routing_wrapper->get_matrix(_locations);
+      _matrix =
+        _routing_wrapper->get_matrix(_locations,
+                                     get_distances ? &_distance_matrix
+                                                   : nullptr);
     }
   }
 
@@ -411,6 +589,9 @@ Solution Input::solve(unsigned exploration_level,
   // Fill vehicle/job compatibility matrix.
   this->set_compatibility();
 
+  // Compute job neighbourhoods for granular local search.
+  this->set_neighbourhoods();
+
   // Load relevant problem.
   auto instance = this->get_problem();
   _end_loading = std::chrono::high_resolution_clock::now();
@@ -419,8 +600,15 @@ Solution Input::solve(unsigned exploration_level,
                    _end_loading - _start_loading)
                    .count();
 
+  // Time spent loading (including matrix computing) is accounted for
+  // in time limit.
+  Deadline deadline;
+  if (timeout.has_value()) {
+    deadline = _start_loading + timeout.value();
+  }
+
   // Solve.
-  auto sol = instance->solve(exploration_level, nb_thread, h_param);
+  auto sol = instance->solve(exploration_level, nb_thread, deadline, h_param);
 
   // Update timing info.
   sol.summary.computing_times.loading = loading;
@@ -432,8 +620,16 @@ Solution Input::solve(unsigned exploration_level,
       .count();
 
   if (_geometry) {
-    for (auto& route : sol.routes) {
-      _routing_wrapper->add_route_info(route);
+    // Route queries are independent, so run them concurrently with at
+    // most nb_thread requests in flight.
+    auto run_add_route_info = [&](std::size_t i) {
+      _routing_wrapper->add_route_info(sol.routes[i]);
+    };
+    utils::ThreadPool::shared().parallel_for(sol.routes.size(),
+                                             nb_thread,
+                                             run_add_route_info);
+
+    for (const auto& route : sol.routes) {
       sol.summary.distance += route.distance;
     }
 
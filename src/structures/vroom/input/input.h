@@ -17,6 +17,7 @@ All rights reserved (see LICENSE).
 #include <vector>
 
 #include "routing/wrapper.h"
+#include "structures/generic/bitset.h"
 #include "structures/generic/matrix.h"
 #include "structures/typedefs.h"
 #include "structures/vroom/job.h"
@@ -39,28 +40,48 @@ private:
   bool _has_TW;
   bool _homogeneous_locations;
   bool _geometry;
+  bool _distances;
+  bool _seed_pruning;
   bool _has_jobs;
   bool _has_shipments;
   bool _has_custom_matrix;
   Matrix<Cost> _matrix;
+  // Only filled from the routing table request when distances are
+  // required without route geometry.
+  Matrix<Distance> _distance_matrix;
   std::vector<Location> _locations;
   std::unordered_map<Location, Index> _locations_to_index;
+  std::unordered_map<Skill, std::size_t> _skill_ranks;
+  std::vector<Bitset> _jobs_skills;
+  std::vector<Bitset> _vehicles_skills;
   std::vector<std::vector<unsigned char>> _vehicle_to_job_compatibility;
   std::vector<std::vector<bool>> _vehicle_to_vehicle_compatibility;
   std::unordered_set<Index> _matrix_used_index;
   bool _all_locations_have_coords;
+  unsigned _nb_neighbours;
+  bool _has_granular_neighbourhoods;
+  std::vector<Cost> _max_out_edge_costs;
+  std::vector<Cost> _max_in_edge_costs;
 
   const unsigned _amount_size;
   const Amount _zero;
 
   std::unique_ptr<VRP> get_problem() const;
 
+  void check_index_range(std::size_t size, const std::string& type) const;
+
   void check_job(Job& job);
 
+  // Skills are remapped to dense ranks upon addition so that skill
+  // sets can be stored as compact bitsets.
+  Bitset get_skills_bitset(const Skills& skills);
+
   void check_cost_bound() const;
 
   void set_compatibility();
 
+  void set_neighbourhoods();
+
 public:
   std::vector<Job> jobs;
   std::vector<Vehicle> vehicles;
@@ -69,6 +90,15 @@ public:
 
   void set_geometry(bool geometry);
 
+  void set_distances(bool distances);
+
+  // Let solving threads stop local search for seeds far behind the
+  // best solution found so far. Results then depend on threads
+  // timing.
+  void set_seed_pruning(bool seed_pruning);
+
+  void set_nb_neighbours(unsigned nb_neighbours);
+
   void set_routing(std::unique_ptr<routing::Wrapper> routing_wrapper);
 
   void add_job(const Job& job);
@@ -85,6 +115,10 @@ public:
 
   bool has_skills() const;
 
+  bool has_seed_pruning() const {
+    return _seed_pruning;
+  }
+
   bool has_jobs() const;
 
   bool has_shipments() const;
@@ -98,16 +132,36 @@ public:
   // Returns true iff both vehicles have common job candidates.
   bool vehicle_ok_with_vehicle(Index v1_index, Index v2_index) const;
 
+  bool has_granular_neighbourhoods() const {
+    return _has_granular_neighbourhoods;
+  }
+
+  // Returns true iff edge from job at rank j1 to job at rank j2 is
+  // among the _nb_neighbours shortest edges leaving j1 or reaching j2.
+  bool is_short_edge(Index j1, Index j2) const {
+    const auto cost = _matrix[jobs[j1].index()][jobs[j2].index()];
+    return cost <= _max_out_edge_costs[j1] or cost <= _max_in_edge_costs[j2];
+  }
+
   const Matrix<Cost>& get_matrix() const {
     return _matrix;
   }
 
+  bool has_distance_matrix() const {
+    return _distance_matrix.size() > 0;
+  }
+
+  const Matrix<Distance>& get_distance_matrix() const {
+    return _distance_matrix;
+  }
+
   Matrix<Cost> get_sub_matrix(const std::vector<Index>& indices) const;
 
   Solution solve(unsigned exploration_level,
                  unsigned nb_thread,
                  const std::vector<HeuristicParameters>& h_param =
-                   std::vector<HeuristicParameters>());
+                   std::vector<HeuristicParameters>(),
+                 const Timeout& timeout = Timeout());
 };
 
 } // namespace vroom
@@ -26,6 +26,8 @@ struct Job {
   const Duration service;
   const Amount delivery;
   const Amount pickup;
+  // Input data only, solving relies on the matching bitset stored
+  // in Input.
   const Skills skills;
   const Priority priority;
   const std::vector<TimeWindow> tws;
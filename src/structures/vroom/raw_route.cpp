@@ -7,17 +7,23 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "structures/vroom/raw_route.h"
 
 namespace vroom {
 
 RawRoute::RawRoute(const Input& input, Index i)
-  : _fwd_peaks(2, input.zero_amount()),
-    _bwd_peaks(2, input.zero_amount()),
+  : _popped_size(0),
     vehicle_rank(i),
     has_start(input.vehicles[i].has_start()),
     has_end(input.vehicles[i].has_end()),
     capacity(input.vehicles[i].capacity) {
+  const auto amount_size = input.zero_amount().size();
+  _fwd_peaks.resize(2, amount_size);
+  _fwd_peaks.set_zero();
+  _bwd_peaks.resize(2, amount_size);
+  _bwd_peaks.set_zero();
 }
 
 void RawRoute::set_route(const Input& input, const std::vector<Index>& r) {
@@ -33,23 +39,57 @@ std::size_t RawRoute::size() const {
   return route.size();
 }
 
+void RawRoute::record_modification(const Index first_rank,
+                                   const Index old_last_rank,
+                                   const Index new_last_rank) {
+  if (!_modified_range) {
+    _modified_range = {first_rank, old_last_rank, new_last_rank};
+    return;
+  }
+
+  // Merge with previous modifications, mapping old_last_rank in the
+  // route before this modification back to a rank in the route as of
+  // last pop.
+  auto& range = _modified_range.value();
+  const long shift = long(range.new_last_rank) - long(range.old_last_rank);
+  const long end = std::max<long>(range.new_last_rank, old_last_rank);
+
+  range.first_rank = std::min(range.first_rank, first_rank);
+  range.old_last_rank = end - shift;
+  range.new_last_rank = end + long(new_last_rank) - long(old_last_rank);
+}
+
+std::optional<RawRoute::ModifiedRange> RawRoute::pop_modified_range() {
+  auto range = _modified_range;
+  assert(!range or _popped_size + range->new_last_rank ==
+                     route.size() + range->old_last_rank);
+
+  _modified_range.reset();
+  _popped_size = route.size();
+  return range;
+}
+
 void RawRoute::update_amounts(const Input& input) {
-  auto step_size = route.size() + 2;
-  _fwd_pickups.resize(route.size());
-  _bwd_deliveries.resize(route.size());
-  _pd_loads.resize(route.size());
+  record_modification(0, _fwd_pickups.size(), route.size());
+
+  const auto amount_size = input.zero_amount().size();
+  const auto step_size = route.size() + 2;
+  _fwd_pickups.resize(route.size(), amount_size);
+  _bwd_deliveries.resize(route.size(), amount_size);
+  _pd_loads.resize(route.size(), amount_size);
   _nb_pickups.resize(route.size());
   _nb_deliveries.resize(route.size());
 
-  _current_loads.resize(step_size);
-  _fwd_peaks.resize(step_size);
-  _bwd_peaks.resize(step_size);
+  _current_loads.resize(step_size, amount_size);
+  _fwd_peaks.resize(step_size, amount_size);
+  _bwd_peaks.resize(step_size, amount_size);
 
   if (route.empty()) {
     // So that check in is_valid_addition_for_capacity is consistent
     // with empty routes.
-    std::fill(_fwd_peaks.begin(), _fwd_peaks.end(), input.zero_amount());
-    std::fill(_bwd_peaks.begin(), _bwd_peaks.end(), input.zero_amount());
+    _current_loads.set_zero();
+    _fwd_peaks.set_zero();
+    _bwd_peaks.set_zero();
     return;
   }
 
@@ -74,8 +114,8 @@ void RawRoute::update_amounts(const Input& input) {
       current_nb_deliveries += 1;
       break;
     }
-    _fwd_pickups[i] = current_pickups;
-    _pd_loads[i] = current_pd_load;
+    _fwd_pickups.assign(i, current_pickups);
+    _pd_loads.assign(i, current_pd_load);
     assert(current_nb_deliveries <= current_nb_pickups);
     _nb_pickups[i] = current_nb_pickups;
     _nb_deliveries[i] = current_nb_deliveries;
@@ -84,40 +124,204 @@ void RawRoute::update_amounts(const Input& input) {
 
   Amount current_deliveries(input.zero_amount());
 
-  _current_loads.back() = _fwd_pickups.back();
+  _current_loads.assign(step_size - 1, _fwd_pickups.back());
 
   for (std::size_t i = 0; i < route.size(); ++i) {
     auto bwd_i = route.size() - i - 1;
 
-    _bwd_deliveries[bwd_i] = current_deliveries;
-    _current_loads[bwd_i + 1] =
-      _fwd_pickups[bwd_i] + _pd_loads[bwd_i] + current_deliveries;
+    _bwd_deliveries.assign(bwd_i, current_deliveries);
+    _current_loads.assign(bwd_i + 1,
+                          _fwd_pickups[bwd_i] + _pd_loads[bwd_i] +
+                            current_deliveries);
     const auto& job = input.jobs[route[bwd_i]];
     if (job.type == JOB_TYPE::SINGLE) {
       current_deliveries += job.delivery;
     }
   }
-  _current_loads[0] = current_deliveries;
-
-  auto peak = _current_loads[0];
-  _fwd_peaks[0] = peak;
-  for (std::size_t s = 1; s < _fwd_peaks.size(); ++s) {
-    // Handle max component-wise.
-    for (std::size_t r = 0; r < input.zero_amount().size(); ++r) {
-      peak[r] = std::max(peak[r], _current_loads[s][r]);
+  _current_loads.assign(0, current_deliveries);
+
+  // Handle peaks component-wise, scanning rows of contiguous values.
+  _fwd_peaks.assign(0, _current_loads[0]);
+  for (std::size_t s = 1; s < step_size; ++s) {
+    const Capacity* previous_peak = _fwd_peaks.row(s - 1);
+    const Capacity* load = _current_loads.row(s);
+    Capacity* peak = _fwd_peaks.row(s);
+    for (std::size_t r = 0; r < amount_size; ++r) {
+      peak[r] = std::max(previous_peak[r], load[r]);
     }
-    _fwd_peaks[s] = peak;
   }
 
-  peak = _current_loads.back();
-  _bwd_peaks.back() = peak;
-  for (std::size_t s = 1; s < _bwd_peaks.size(); ++s) {
-    auto bwd_s = _bwd_peaks.size() - s - 1;
-    // Handle max component-wise.
-    for (std::size_t r = 0; r < input.zero_amount().size(); ++r) {
-      peak[r] = std::max(peak[r], _current_loads[bwd_s][r]);
+  _bwd_peaks.assign(step_size - 1, _current_loads.back());
+  for (std::size_t s = 1; s < step_size; ++s) {
+    auto bwd_s = step_size - s - 1;
+    const Capacity* next_peak = _bwd_peaks.row(bwd_s + 1);
+    const Capacity* load = _current_loads.row(bwd_s);
+    Capacity* peak = _bwd_peaks.row(bwd_s);
+    for (std::size_t r = 0; r < amount_size; ++r) {
+      peak[r] = std::max(next_peak[r], load[r]);
     }
-    _bwd_peaks[bwd_s] = peak;
+  }
+}
+
+void RawRoute::update_amounts(const Input& input,
+                              const Index first_rank,
+                              const Index old_last_rank,
+                              const Index new_last_rank) {
+  assert(first_rank <= old_last_rank and first_rank <= new_last_rank);
+  const std::size_t old_size = _fwd_pickups.size();
+  const std::size_t size = route.size();
+  assert(old_size + new_last_rank == size + old_last_rank);
+
+  if (old_size == 0 or size == 0) {
+    update_amounts(input);
+    return;
+  }
+
+  record_modification(first_rank, old_last_rank, new_last_rank);
+
+  // Align stored values for unmodified jobs with their new ranks.
+  const std::size_t nb_old = old_last_rank - first_rank;
+  const std::size_t nb_new = new_last_rank - first_rank;
+  _fwd_pickups.replace_rows(first_rank, nb_old, nb_new);
+  _bwd_deliveries.replace_rows(first_rank, nb_old, nb_new);
+  _pd_loads.replace_rows(first_rank, nb_old, nb_new);
+  if (nb_old < nb_new) {
+    _nb_pickups.insert(_nb_pickups.begin() + first_rank, nb_new - nb_old, 0);
+    _nb_deliveries.insert(_nb_deliveries.begin() + first_rank,
+                          nb_new - nb_old,
+                          0);
+  } else {
+    _nb_pickups.erase(_nb_pickups.begin() + first_rank,
+                      _nb_pickups.begin() + first_rank + nb_old - nb_new);
+    _nb_deliveries.erase(_nb_deliveries.begin() + first_rank,
+                         _nb_deliveries.begin() + first_rank + nb_old -
+                           nb_new);
+  }
+  // Step for job at rank r is r + 1.
+  _current_loads.replace_rows(first_rank + 1, nb_old, nb_new);
+  _fwd_peaks.replace_rows(first_rank + 1, nb_old, nb_new);
+  _bwd_peaks.replace_rows(first_rank + 1, nb_old, nb_new);
+
+  const auto& zero = input.zero_amount();
+
+  // Propagate forward values from first_rank, stopping after the
+  // modified range as soon as values are back to the previous ones.
+  Amount current_pickups =
+    (first_rank == 0) ? zero : Amount(_fwd_pickups[first_rank - 1]);
+  Amount current_pd_load =
+    (first_rank == 0) ? zero : Amount(_pd_loads[first_rank - 1]);
+  unsigned current_nb_pickups =
+    (first_rank == 0) ? 0 : _nb_pickups[first_rank - 1];
+  unsigned current_nb_deliveries =
+    (first_rank == 0) ? 0 : _nb_deliveries[first_rank - 1];
+
+  std::size_t fwd_end = size;
+  for (std::size_t i = first_rank; i < size; ++i) {
+    const auto& job = input.jobs[route[i]];
+    switch (job.type) {
+    case JOB_TYPE::SINGLE:
+      current_pickups += job.pickup;
+      break;
+    case JOB_TYPE::PICKUP:
+      current_pd_load += job.pickup;
+      current_nb_pickups += 1;
+      break;
+    case JOB_TYPE::DELIVERY:
+      assert(job.delivery <= current_pd_load);
+      current_pd_load -= job.delivery;
+      current_nb_deliveries += 1;
+      break;
+    }
+
+    if (new_last_rank <= i and current_pickups == _fwd_pickups[i] and
+        current_pd_load == _pd_loads[i] and
+        current_nb_pickups == _nb_pickups[i] and
+        current_nb_deliveries == _nb_deliveries[i]) {
+      fwd_end = i;
+      break;
+    }
+
+    _fwd_pickups.assign(i, current_pickups);
+    _pd_loads.assign(i, current_pd_load);
+    assert(current_nb_deliveries <= current_nb_pickups);
+    _nb_pickups[i] = current_nb_pickups;
+    _nb_deliveries[i] = current_nb_deliveries;
+  }
+  assert(_pd_loads.back() == zero);
+
+  // Propagate backward values from new_last_rank, stopping before the
+  // modified range as soon as values are back to the previous ones.
+  Amount current_deliveries(zero);
+  if (new_last_rank < size) {
+    current_deliveries = _bwd_deliveries[new_last_rank];
+    const auto& job = input.jobs[route[new_last_rank]];
+    if (job.type == JOB_TYPE::SINGLE) {
+      current_deliveries += job.delivery;
+    }
+  }
+
+  std::size_t bwd_begin = 0;
+  bool total_deliveries_changed = true;
+  for (std::size_t i = new_last_rank; i > 0; --i) {
+    const auto bwd_i = i - 1;
+    if (bwd_i < first_rank and current_deliveries == _bwd_deliveries[bwd_i]) {
+      bwd_begin = i;
+      total_deliveries_changed = false;
+      break;
+    }
+
+    _bwd_deliveries.assign(bwd_i, current_deliveries);
+    const auto& job = input.jobs[route[bwd_i]];
+    if (job.type == JOB_TYPE::SINGLE) {
+      current_deliveries += job.delivery;
+    }
+  }
+
+  // Loads only change for steps matching ranks in [bwd_begin;
+  // fwd_end), plus start and end steps.
+  const std::size_t step_size = size + 2;
+  if (total_deliveries_changed) {
+    _current_loads.assign(0, current_deliveries);
+  }
+  for (std::size_t i = bwd_begin; i < fwd_end; ++i) {
+    _current_loads.assign(i + 1,
+                          _fwd_pickups[i] + _pd_loads[i] +
+                            _bwd_deliveries[i]);
+  }
+  _current_loads.assign(step_size - 1, _fwd_pickups.back());
+
+  const std::size_t first_step = total_deliveries_changed ? 0 : bwd_begin + 1;
+  const std::size_t last_step = (fwd_end == size) ? step_size : fwd_end + 1;
+
+  // Update peaks component-wise, stopping outside the range of
+  // changed loads as soon as peaks are back to the previous ones.
+  const std::size_t amount_size = zero.size();
+  Amount peak(amount_size);
+
+  for (std::size_t s = first_step; s < step_size; ++s) {
+    const Capacity* load = _current_loads.row(s);
+    const Capacity* previous_peak = (s == 0) ? load : _fwd_peaks.row(s - 1);
+    for (std::size_t r = 0; r < amount_size; ++r) {
+      peak[r] = std::max(previous_peak[r], load[r]);
+    }
+    if (last_step <= s and peak == _fwd_peaks[s]) {
+      break;
+    }
+    _fwd_peaks.assign(s, peak);
+  }
+
+  for (std::size_t s = last_step; s > 0; --s) {
+    const auto bwd_s = s - 1;
+    const Capacity* load = _current_loads.row(bwd_s);
+    const Capacity* next_peak =
+      (bwd_s == step_size - 1) ? load : _bwd_peaks.row(bwd_s + 1);
+    for (std::size_t r = 0; r < amount_size; ++r) {
+      peak[r] = std::max(next_peak[r], load[r]);
+    }
+    if (bwd_s < first_step and peak == _bwd_peaks[bwd_s]) {
+      break;
+    }
+    _bwd_peaks.assign(bwd_s, peak);
   }
 }
 
@@ -135,7 +339,7 @@ bool RawRoute::has_pickup_up_to_rank(const Index rank) const {
   return 0 < _nb_pickups[rank];
 }
 
-const Amount& RawRoute::max_load() const {
+AmountView RawRoute::max_load() const {
   return _fwd_peaks.back();
 }
 
@@ -154,7 +358,8 @@ bool RawRoute::is_valid_addition_for_load(const Input& input,
                                           const Index rank) const {
   assert(rank <= route.size());
 
-  auto& load = route.empty() ? input.zero_amount() : _current_loads[rank];
+  const AmountView load =
+    route.empty() ? AmountView(input.zero_amount()) : _current_loads[rank];
   return load + pickup <= capacity;
 }
 
@@ -167,13 +372,15 @@ bool RawRoute::is_valid_addition_for_capacity_margins(
   assert(1 <= last_rank);
   assert(last_rank <= route.size() + 1);
 
-  auto& first_deliveries =
+  const AmountView first_deliveries =
     (first_rank == 0) ? _current_loads[0] : _bwd_deliveries[first_rank - 1];
 
-  auto& first_pickups =
-    (first_rank == 0) ? input.zero_amount() : _fwd_pickups[first_rank - 1];
+  const AmountView first_pickups = (first_rank == 0)
+                                     ? AmountView(input.zero_amount())
+                                     : _fwd_pickups[first_rank - 1];
 
-  auto replaced_deliveries = first_deliveries - _bwd_deliveries[last_rank - 1];
+  const Amount replaced_deliveries =
+    first_deliveries - _bwd_deliveries[last_rank - 1];
 
   return (_fwd_peaks[first_rank] + delivery <=
           capacity + replaced_deliveries) and
@@ -192,19 +399,22 @@ bool RawRoute::is_valid_addition_for_capacity_inclusion(
   assert(first_rank <= last_rank);
   assert(last_rank <= route.size() + 1);
 
-  auto& init_load = (route.empty()) ? input.zero_amount() : _current_loads[0];
+  const AmountView init_load =
+    (route.empty()) ? AmountView(input.zero_amount()) : _current_loads[0];
 
-  auto& first_deliveries =
+  const AmountView first_deliveries =
     (first_rank == 0) ? init_load : _bwd_deliveries[first_rank - 1];
 
-  auto& last_deliveries =
+  const AmountView last_deliveries =
     (last_rank == 0) ? init_load : _bwd_deliveries[last_rank - 1];
 
-  auto replaced_deliveries = first_deliveries - last_deliveries;
+  const Amount replaced_deliveries = first_deliveries - last_deliveries;
 
-  Amount current_load =
-    ((route.empty()) ? input.zero_amount() : _current_loads[first_rank]) -
-    replaced_deliveries + delivery;
+  const AmountView first_load = (route.empty())
+                                  ? AmountView(input.zero_amount())
+                                  : _current_loads[first_rank];
+
+  Amount current_load = first_load - replaced_deliveries + delivery;
 
   bool valid = (current_load <= capacity);
 
@@ -238,21 +448,21 @@ Amount RawRoute::delivery_in_range(Index i, Index j) const {
   if (i == j) {
     return Amount(_current_loads[0].size());
   }
-  auto& before_deliveries =
+  const AmountView before_deliveries =
     (i == 0) ? _current_loads[0] : _bwd_deliveries[i - 1];
   return before_deliveries - _bwd_deliveries[j - 1];
 }
 
 void RawRoute::add(const Input& input, const Index job_rank, const Index rank) {
   route.insert(route.begin() + rank, job_rank);
-  update_amounts(input);
+  update_amounts(input, rank, rank, rank + 1);
 }
 
 void RawRoute::remove(const Input& input,
                       const Index rank,
                       const unsigned count) {
   route.erase(route.begin() + rank, route.begin() + rank + count);
-  update_amounts(input);
+  update_amounts(input, rank, rank + count, rank);
 }
 
 template <class InputIterator>
@@ -266,7 +476,10 @@ void RawRoute::replace(const Input& input,
   route.erase(route.begin() + first_rank, route.begin() + last_rank);
   route.insert(route.begin() + first_rank, first_job, last_job);
 
-  update_amounts(input);
+  update_amounts(input,
+                 first_rank,
+                 last_rank,
+                 first_rank + std::distance(first_job, last_job));
 }
 
 template bool RawRoute::is_valid_addition_for_capacity_inclusion(
@@ -10,6 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <optional>
 #include <vector>
 
 #include "structures/typedefs.h"
@@ -19,16 +20,19 @@ namespace vroom {
 
 class RawRoute {
 private:
+  // Per-rank (resp. per-step) amounts below are stored in contiguous
+  // buffers reused across updates.
+
   // _fwd_pickups[i] stores the total pickups for single jobs up to
   // rank i.
-  std::vector<Amount> _fwd_pickups;
+  AmountArray _fwd_pickups;
 
   // _bwd_deliveries[i] stores the total deliveries for single jobs
   // pending after rank i.
-  std::vector<Amount> _bwd_deliveries;
+  AmountArray _bwd_deliveries;
 
   // _pd_loads[i] stores the shipments load at rank i (included).
-  std::vector<Amount> _pd_loads;
+  AmountArray _pd_loads;
 
   // _nb_pickups[i] (resp. _nb_deliveries[i]) stores the number of
   // pickups (resp. deliveries) up to rank i.
@@ -38,13 +42,32 @@ private:
   // _current_loads[s] stores the vehicle load (taking all job types
   // into account) at *step* s (step 0 is the start, not the first job
   // rank).
-  std::vector<Amount> _current_loads;
+  AmountArray _current_loads;
 
   // _fwd_peaks[s] stores the peak load (component-wise) up to *step*
   // s. _bwd_peaks[s] stores the peak load (component-wise) after
   // *step* s.
-  std::vector<Amount> _fwd_peaks;
-  std::vector<Amount> _bwd_peaks;
+  AmountArray _fwd_peaks;
+  AmountArray _bwd_peaks;
+
+public:
+  // Jobs in [first_rank; old_last_rank) of a previous route replaced
+  // with the jobs now in [first_rank; new_last_rank).
+  struct ModifiedRange {
+    Index first_rank;
+    Index old_last_rank;
+    Index new_last_rank;
+  };
+
+private:
+  // Range covering all modifications since last call to
+  // pop_modified_range, and route size as of that call.
+  std::optional<ModifiedRange> _modified_range;
+  std::size_t _popped_size;
+
+  void record_modification(const Index first_rank,
+                           const Index old_last_rank,
+                           const Index new_last_rank);
 
 public:
   Index vehicle_rank;
@@ -64,13 +87,25 @@ public:
 
   void update_amounts(const Input& input);
 
+  // Update amounts after jobs in the range [first_rank;
+  // old_last_rank) of the previous route have been replaced with the
+  // jobs now in the range [first_rank; new_last_rank). Only values
+  // that may have changed are recomputed.
+  void update_amounts(const Input& input,
+                      const Index first_rank,
+                      const Index old_last_rank,
+                      const Index new_last_rank);
+
+  // Return the range modified since last call, if any.
+  std::optional<ModifiedRange> pop_modified_range();
+
   bool has_pending_delivery_after_rank(const Index rank) const;
 
   bool has_delivery_after_rank(const Index rank) const;
 
   bool has_pickup_up_to_rank(const Index rank) const;
 
-  const Amount& max_load() const;
+  AmountView max_load() const;
 
   // Check validity for addition of a given load in current route at
   // rank.
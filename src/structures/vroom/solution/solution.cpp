@@ -30,6 +30,7 @@ Solution::Solution(unsigned code,
     summary.pickup += route.pickup;
     summary.service += route.service;
     summary.duration += route.duration;
+    summary.distance += route.distance;
     summary.waiting_time += route.waiting_time;
   }
 }
@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cassert>
 #include <numeric>
 #include <unordered_map>
 
@@ -16,10 +18,33 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace utils {
 
+// Resize values to new_size by inserting or erasing values at rank
+// first, so that following values are shifted accordingly.
+template <class T>
+inline void
+resize_at(std::vector<T>& values, std::size_t first, std::size_t new_size) {
+  if (values.size() < new_size) {
+    values.insert(values.begin() + first, new_size - values.size(), T());
+  } else {
+    values.erase(values.begin() + first,
+                 values.begin() + first + (values.size() - new_size));
+  }
+}
+
+// Rank of the first maximum value in a non-empty vector.
+inline Index first_max_rank(const std::vector<Gain>& values) {
+  assert(!values.empty());
+  return std::distance(values.begin(),
+                       std::max_element(values.begin(), values.end()));
+}
+
 SolutionState::SolutionState(const Input& input)
   : _input(input),
     _m(_input.get_matrix()),
     _nb_vehicles(_input.vehicles.size()),
+    _route_versions(_nb_vehicles, 0),
+    _nearest_ranks_blocks(_nb_vehicles * _nb_vehicles),
+    _nearest_ranks_arena_used(0),
     fwd_costs(_nb_vehicles),
     bwd_costs(_nb_vehicles),
     fwd_skill_rank(_nb_vehicles, std::vector<Index>(_nb_vehicles)),
@@ -33,12 +58,6 @@ SolutionState::SolutionState(const Input& input)
     pd_gains(_nb_vehicles),
     matching_delivery_rank(_nb_vehicles),
     matching_pickup_rank(_nb_vehicles),
-    nearest_job_rank_in_routes_from(_nb_vehicles,
-                                    std::vector<std::vector<Index>>(
-                                      _nb_vehicles)),
-    nearest_job_rank_in_routes_to(_nb_vehicles,
-                                  std::vector<std::vector<Index>>(
-                                    _nb_vehicles)),
     route_costs(_nb_vehicles) {
 }
 
@@ -49,11 +68,40 @@ void SolutionState::setup(const std::vector<Index>& r, Index v) {
   set_edge_gains(r, v);
   set_pd_matching_ranks(r, v);
   set_pd_gains(r, v);
+  ++_route_versions[v];
 #ifndef NDEBUG
   update_route_cost(r, v);
 #endif
 }
 
+void SolutionState::update(const std::vector<Index>& route,
+                           Index v,
+                           Index first_rank,
+                           Index old_last_rank,
+                           Index new_last_rank) {
+  const std::size_t old_size = fwd_costs[v].size();
+  assert(first_rank <= old_last_rank and old_last_rank <= old_size);
+  assert(first_rank <= new_last_rank and new_last_rank <= route.size());
+  assert(old_size - old_last_rank == route.size() - new_last_rank);
+
+  if (old_size == 0 or route.empty()) {
+    setup(route, v);
+    return;
+  }
+
+  update_costs(route, v, first_rank, new_last_rank);
+  update_skills(route, v, first_rank, old_last_rank, new_last_rank);
+  set_node_gains(route, v, first_rank, new_last_rank);
+  set_edge_gains(route, v, first_rank, new_last_rank);
+  set_pd_matching_ranks(route, v, first_rank, old_last_rank, new_last_rank);
+  set_pd_gains(route, v, first_rank, new_last_rank);
+
+  ++_route_versions[v];
+#ifndef NDEBUG
+  update_route_cost(route, v);
+#endif
+}
+
 void SolutionState::setup(const RawSolution& sol) {
   for (std::size_t v = 0; v < _nb_vehicles; ++v) {
     setup(sol[v].route, v);
@@ -114,6 +162,44 @@ void SolutionState::update_costs(const std::vector<Index>& route, Index v) {
   }
 }
 
+void SolutionState::update_costs(const std::vector<Index>& route,
+                                 Index v,
+                                 Index first_rank,
+                                 Index new_last_rank) {
+  auto& fwd = fwd_costs[v];
+  auto& bwd = bwd_costs[v];
+  resize_at(fwd, first_rank, route.size());
+  resize_at(bwd, first_rank, route.size());
+
+  // Costs after new_last_rank are only shifted by the cost difference
+  // at new_last_rank. Unsigned wrap-around is fine here as final
+  // values are valid costs.
+  const bool has_suffix = new_last_rank < route.size();
+  const Cost old_fwd_at_last = has_suffix ? fwd[new_last_rank] : 0;
+  const Cost old_bwd_at_last = has_suffix ? bwd[new_last_rank] : 0;
+
+  if (first_rank == 0) {
+    fwd[0] = 0;
+    bwd[0] = 0;
+  }
+
+  const std::size_t end =
+    std::min(static_cast<std::size_t>(new_last_rank) + 1, route.size());
+  for (std::size_t i = std::max<std::size_t>(first_rank, 1); i < end; ++i) {
+    const auto previous_index = _input.jobs[route[i - 1]].index();
+    const auto current_index = _input.jobs[route[i]].index();
+    fwd[i] = fwd[i - 1] + _m[previous_index][current_index];
+    bwd[i] = bwd[i - 1] + _m[current_index][previous_index];
+  }
+
+  if (has_suffix) {
+    for (std::size_t i = end; i < route.size(); ++i) {
+      fwd[i] = fwd[i] - old_fwd_at_last + fwd[new_last_rank];
+      bwd[i] = bwd[i] - old_bwd_at_last + bwd[new_last_rank];
+    }
+  }
+}
+
 void SolutionState::update_skills(const std::vector<Index>& route, Index v1) {
   for (std::size_t v2 = 0; v2 < _nb_vehicles; ++v2) {
     if (v1 == v2) {
@@ -132,245 +218,285 @@ void SolutionState::update_skills(const std::vector<Index>& route, Index v1) {
   }
 }
 
-void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
-  node_gains[v] = std::vector<Gain>(route.size());
-  edge_costs_around_node[v] = std::vector<Gain>(route.size());
-
-  if (route.size() == 0) {
-    return;
-  }
-
-  // Handling first job is special due to potential open tours.
-  Index p_index;
-  Index c_index = _input.jobs[route[0]].index();
-  Index n_index;
-
-  Gain previous_cost = 0;
-  Gain next_cost = 0;
-  Gain new_edge_cost = 0;
+void SolutionState::update_skills(const std::vector<Index>& route,
+                                  Index v1,
+                                  Index first_rank,
+                                  Index old_last_rank,
+                                  Index new_last_rank) {
+  const auto first = route.begin() + first_rank;
+  const auto new_last = route.begin() + new_last_rank;
+  const auto r_first = std::make_reverse_iterator(first);
+  const auto r_new_last = std::make_reverse_iterator(new_last);
 
-  if (_input.vehicles[v].has_start()) {
-    // There is a previous step before job at rank 0.
-    p_index = _input.vehicles[v].start.value().index();
-    previous_cost = _m[p_index][c_index];
+  for (std::size_t v2 = 0; v2 < _nb_vehicles; ++v2) {
+    if (v1 == v2) {
+      continue;
+    }
 
-    // Update next_cost with next job or end.
-    if (route.size() > 1) {
-      n_index = _input.jobs[route[1]].index();
-      next_cost = _m[c_index][n_index];
-      new_edge_cost = _m[p_index][n_index];
-    } else {
-      // route.size() is 1 and first job is also the last.
-      if (_input.vehicles[v].has_end()) {
-        next_cost = _m[c_index][_input.vehicles[v].end.value().index()];
+    const auto ok = [&](auto j_rank) {
+      return _input.vehicle_ok_with_job(v2, j_rank);
+    };
+
+    // First incompatible job is unchanged if located before modified
+    // range, else it is either in new range or shifted, unless it
+    // has been removed from the route.
+    auto& fwd_rank = fwd_skill_rank[v1][v2];
+    if (first_rank <= fwd_rank) {
+      auto fwd = std::find_if_not(first, new_last, ok);
+      if (fwd != new_last) {
+        fwd_rank = std::distance(route.begin(), fwd);
+      } else if (old_last_rank <= fwd_rank) {
+        fwd_rank = fwd_rank - old_last_rank + new_last_rank;
+      } else {
+        fwd = std::find_if_not(new_last, route.end(), ok);
+        fwd_rank = std::distance(route.begin(), fwd);
       }
     }
-  } else {
-    // There is a next cost either to next job or to end of route, but
-    // no new edge.
-    if (route.size() > 1) {
-      n_index = _input.jobs[route[1]].index();
+
+    // Same logic backward for last incompatible job.
+    auto& bwd_rank = bwd_skill_rank[v1][v2];
+    if (old_last_rank < bwd_rank) {
+      bwd_rank = bwd_rank - old_last_rank + new_last_rank;
     } else {
-      assert(_input.vehicles[v].has_end());
-      n_index = _input.vehicles[v].end.value().index();
+      auto bwd = std::find_if_not(r_new_last, r_first, ok);
+      if (bwd != r_first) {
+        bwd_rank = route.size() - std::distance(route.rbegin(), bwd);
+      } else if (first_rank < bwd_rank) {
+        bwd = std::find_if_not(r_first, route.rend(), ok);
+        bwd_rank = route.size() - std::distance(route.rbegin(), bwd);
+      }
     }
-    next_cost = _m[c_index][n_index];
   }
+}
 
-  Gain edges_costs_around = previous_cost + next_cost;
-  edge_costs_around_node[v][0] = edges_costs_around;
-
-  Gain current_gain = edges_costs_around - new_edge_cost;
-  node_gains[v][0] = current_gain;
-  Gain best_gain = current_gain;
-  node_candidates[v] = 0;
-
-  if (route.size() == 1) {
-    // No more jobs.
-    return;
+void SolutionState::set_node_gain(const std::vector<Index>& route,
+                                  Index v,
+                                  Index i) {
+  const auto& vehicle = _input.vehicles[v];
+  const Index c_index = _input.jobs[route[i]].index();
+
+  // Handle potential open tours for first and last jobs.
+  bool has_previous_step = false;
+  Index p_index = 0; // dummy init
+  if (i > 0) {
+    has_previous_step = true;
+    p_index = _input.jobs[route[i - 1]].index();
+  } else if (vehicle.has_start()) {
+    has_previous_step = true;
+    p_index = vehicle.start.value().index();
   }
 
-  // Handle jobs that always have a previous and next job.
-  for (std::size_t i = 1; i < route.size() - 1; ++i) {
-    // Compute potential gain to relocate current job.
-    p_index = _input.jobs[route[i - 1]].index();
-    c_index = _input.jobs[route[i]].index();
+  bool has_next_step = false;
+  Index n_index = 0; // dummy init
+  if (i < route.size() - 1) {
+    has_next_step = true;
     n_index = _input.jobs[route[i + 1]].index();
-
-    edges_costs_around = _m[p_index][c_index] + _m[c_index][n_index];
-    edge_costs_around_node[v][i] = edges_costs_around;
-
-    current_gain = edges_costs_around - _m[p_index][n_index];
-    node_gains[v][i] = current_gain;
-
-    if (current_gain > best_gain) {
-      best_gain = current_gain;
-      node_candidates[v] = i;
-    }
+  } else if (vehicle.has_end()) {
+    has_next_step = true;
+    n_index = vehicle.end.value().index();
   }
+  assert(has_previous_step or has_next_step);
 
-  // Handling last job is special due to potential open tours.
-  auto last_rank = route.size() - 1;
-  c_index = _input.jobs[route[last_rank]].index();
-
-  previous_cost = 0;
-  next_cost = 0;
-  new_edge_cost = 0;
-
-  if (_input.vehicles[v].has_end()) {
-    // There is a next step after last job.
-    n_index = _input.vehicles[v].end.value().index();
-    next_cost = _m[c_index][n_index];
+  Gain previous_cost = 0;
+  Gain next_cost = 0;
+  Gain new_edge_cost = 0;
 
-    if (route.size() > 1) {
-      p_index = _input.jobs[route[last_rank - 1]].index();
-      previous_cost = _m[p_index][c_index];
-      new_edge_cost = _m[p_index][n_index];
-    }
-  } else {
-    // There is a previous cost either from previous job or from start
-    // of route, but no new edge.
-    if (route.size() > 1) {
-      p_index = _input.jobs[route[last_rank - 1]].index();
-    } else {
-      assert(_input.vehicles[v].has_start());
-      p_index = _input.vehicles[v].start.value().index();
-    }
+  if (has_previous_step) {
     previous_cost = _m[p_index][c_index];
   }
+  if (has_next_step) {
+    next_cost = _m[c_index][n_index];
+  }
+  if (has_previous_step and has_next_step and route.size() > 1) {
+    // No new edge with an open trip or if removing job creates an
+    // empty route.
+    new_edge_cost = _m[p_index][n_index];
+  }
 
-  edges_costs_around = previous_cost + next_cost;
-  edge_costs_around_node[v][last_rank] = edges_costs_around;
+  const Gain edges_costs_around = previous_cost + next_cost;
+  edge_costs_around_node[v][i] = edges_costs_around;
+  node_gains[v][i] = edges_costs_around - new_edge_cost;
+}
+
+void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
+  node_gains[v] = std::vector<Gain>(route.size());
+  edge_costs_around_node[v] = std::vector<Gain>(route.size());
 
-  current_gain = edges_costs_around - new_edge_cost;
-  node_gains[v][last_rank] = current_gain;
+  for (std::size_t i = 0; i < route.size(); ++i) {
+    set_node_gain(route, v, i);
+  }
 
-  if (current_gain > best_gain) {
-    node_candidates[v] = last_rank;
+  if (!route.empty()) {
+    node_candidates[v] = first_max_rank(node_gains[v]);
   }
 }
 
-void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
-  std::size_t nb_edges = (route.size() < 2) ? 0 : route.size() - 1;
+void SolutionState::set_node_gains(const std::vector<Index>& route,
+                                   Index v,
+                                   Index first_rank,
+                                   Index new_last_rank) {
+  resize_at(node_gains[v], first_rank, route.size());
+  resize_at(edge_costs_around_node[v], first_rank, route.size());
+
+  // Gains for jobs next to the modified range also change.
+  const std::size_t begin = (first_rank > 0) ? first_rank - 1 : 0;
+  const std::size_t end =
+    std::min(static_cast<std::size_t>(new_last_rank) + 1, route.size());
+  for (std::size_t i = begin; i < end; ++i) {
+    set_node_gain(route, v, i);
+  }
 
-  edge_gains[v] = std::vector<Gain>(nb_edges);
-  edge_costs_around_edge[v] = std::vector<Gain>(nb_edges);
+  if (!route.empty()) {
+    node_candidates[v] = first_max_rank(node_gains[v]);
+  }
+}
 
-  if (route.size() < 2) {
-    return;
+void SolutionState::set_edge_gain(const std::vector<Index>& route,
+                                  Index v,
+                                  Index i) {
+  const auto& vehicle = _input.vehicles[v];
+  const Index c_index = _input.jobs[route[i]].index();
+  const Index after_c_index = _input.jobs[route[i + 1]].index();
+
+  // Handle potential open tours for first and last edges.
+  bool has_previous_step = false;
+  Index p_index = 0; // dummy init
+  if (i > 0) {
+    has_previous_step = true;
+    p_index = _input.jobs[route[i - 1]].index();
+  } else if (vehicle.has_start()) {
+    has_previous_step = true;
+    p_index = vehicle.start.value().index();
   }
 
-  // Handling first edge is special due to potential open tours.
-  Index p_index;
-  Index c_index = _input.jobs[route[0]].index();
-  Index after_c_index = _input.jobs[route[1]].index();
-  Index n_index;
+  bool has_next_step = false;
+  Index n_index = 0; // dummy init
+  if (i < route.size() - 2) {
+    has_next_step = true;
+    n_index = _input.jobs[route[i + 2]].index();
+  } else if (vehicle.has_end()) {
+    has_next_step = true;
+    n_index = vehicle.end.value().index();
+  }
+  assert(has_previous_step or has_next_step);
 
   Gain previous_cost = 0;
   Gain next_cost = 0;
   Gain new_edge_cost = 0;
 
-  if (_input.vehicles[v].has_start()) {
-    // There is a previous step before job at rank 0.
-    p_index = _input.vehicles[v].start.value().index();
+  if (has_previous_step) {
     previous_cost = _m[p_index][c_index];
-
-    // Update next_cost with next job or end.
-    if (route.size() > 2) {
-      n_index = _input.jobs[route[2]].index();
-      next_cost = _m[after_c_index][n_index];
-      new_edge_cost = _m[p_index][n_index];
-    } else {
-      // route.size() is 2 and first edge is also the last.
-      if (_input.vehicles[v].has_end()) {
-        next_cost = _m[after_c_index][_input.vehicles[v].end.value().index()];
-      }
-    }
-  } else {
-    // There is a next cost either to next job or to end of route, but
-    // no new edge.
-    if (route.size() > 2) {
-      n_index = _input.jobs[route[2]].index();
-    } else {
-      assert(_input.vehicles[v].has_end());
-      n_index = _input.vehicles[v].end.value().index();
-    }
+  }
+  if (has_next_step) {
     next_cost = _m[after_c_index][n_index];
   }
-
-  Gain edges_costs_around = previous_cost + next_cost;
-  edge_costs_around_edge[v][0] = edges_costs_around;
-
-  Gain current_gain = edges_costs_around - new_edge_cost;
-  edge_gains[v][0] = current_gain;
-  Gain best_gain = current_gain;
-  edge_candidates[v] = 0;
-
-  if (route.size() == 2) {
-    // No more edges.
-    return;
+  if (has_previous_step and has_next_step and route.size() > 2) {
+    // No new edge with an open trip or if removing edge creates an
+    // empty route.
+    new_edge_cost = _m[p_index][n_index];
   }
 
-  // Handle edges that always have a previous and next job.
-  for (std::size_t i = 1; i < nb_edges - 1; ++i) {
-    // Compute potential gain to relocate edge from current to next
-    // job.
-    p_index = _input.jobs[route[i - 1]].index();
-    c_index = _input.jobs[route[i]].index();
-    after_c_index = _input.jobs[route[i + 1]].index();
-    n_index = _input.jobs[route[i + 2]].index();
+  const Gain edges_costs_around = previous_cost + next_cost;
+  edge_costs_around_edge[v][i] = edges_costs_around;
+  edge_gains[v][i] = edges_costs_around - new_edge_cost;
+}
 
-    edges_costs_around = _m[p_index][c_index] + _m[after_c_index][n_index];
-    edge_costs_around_edge[v][i] = edges_costs_around;
+void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
+  std::size_t nb_edges = (route.size() < 2) ? 0 : route.size() - 1;
 
-    current_gain = edges_costs_around - _m[p_index][n_index];
-    edge_gains[v][i] = current_gain;
+  edge_gains[v] = std::vector<Gain>(nb_edges);
+  edge_costs_around_edge[v] = std::vector<Gain>(nb_edges);
 
-    if (current_gain > best_gain) {
-      best_gain = current_gain;
-      edge_candidates[v] = i;
-    }
+  for (std::size_t i = 0; i < nb_edges; ++i) {
+    set_edge_gain(route, v, i);
   }
 
-  // Handling last edge is special due to potential open tours.
-  auto last_edge_rank = nb_edges - 1;
-  c_index = _input.jobs[route[last_edge_rank]].index();
-  after_c_index = _input.jobs[route[last_edge_rank + 1]].index();
+  if (nb_edges > 0) {
+    edge_candidates[v] = first_max_rank(edge_gains[v]);
+  }
+}
 
-  previous_cost = 0;
-  next_cost = 0;
-  new_edge_cost = 0;
+void SolutionState::set_edge_gains(const std::vector<Index>& route,
+                                   Index v,
+                                   Index first_rank,
+                                   Index new_last_rank) {
+  std::size_t nb_edges = (route.size() < 2) ? 0 : route.size() - 1;
 
-  if (_input.vehicles[v].has_end()) {
-    // There is a next step after last job.
-    n_index = _input.vehicles[v].end.value().index();
-    next_cost = _m[after_c_index][n_index];
+  // Edge starting at rank first_rank - 1 ends in the modified range.
+  const std::size_t first_edge_rank = (first_rank > 0) ? first_rank - 1 : 0;
+  resize_at(edge_gains[v], first_edge_rank, nb_edges);
+  resize_at(edge_costs_around_edge[v], first_edge_rank, nb_edges);
+
+  // Gains for edges next to the modified range also change.
+  const std::size_t begin = (first_rank > 1) ? first_rank - 2 : 0;
+  const std::size_t end =
+    std::min(static_cast<std::size_t>(new_last_rank) + 1, nb_edges);
+  for (std::size_t i = begin; i < end; ++i) {
+    set_edge_gain(route, v, i);
+  }
 
-    if (route.size() > 2) {
-      p_index = _input.jobs[route[last_edge_rank - 1]].index();
-      previous_cost = _m[p_index][c_index];
-      new_edge_cost = _m[p_index][n_index];
-    }
-  } else {
-    // There is a previous cost either from previous job or from start
-    // of route, but no new edge.
-    if (route.size() > 2) {
-      p_index = _input.jobs[route[last_edge_rank - 1]].index();
+  if (nb_edges > 0) {
+    edge_candidates[v] = first_max_rank(edge_gains[v]);
+  }
+}
+
+void SolutionState::set_pd_gain(const std::vector<Index>& route,
+                                Index v,
+                                Index pickup_rank) {
+  assert(_input.jobs[route[pickup_rank]].type == JOB_TYPE::PICKUP);
+  Index pickup_index = _input.jobs[route[pickup_rank]].index();
+  Index delivery_rank = matching_delivery_rank[v][pickup_rank];
+  Index delivery_index = _input.jobs[route[delivery_rank]].index();
+
+  if (pickup_rank + 1 == delivery_rank) {
+    // Pickup and delivery in a row.
+    Gain previous_cost = 0;
+    Gain next_cost = 0;
+    Gain new_edge_cost = 0;
+    Index p_index;
+    Index n_index;
+
+    // Compute cost for step before pickup.
+    bool has_previous_step = false;
+    if (pickup_rank > 0) {
+      has_previous_step = true;
+      p_index = _input.jobs[route[pickup_rank - 1]].index();
+      previous_cost = _m[p_index][pickup_index];
     } else {
-      assert(_input.vehicles[v].has_start());
-      p_index = _input.vehicles[v].start.value().index();
+      if (_input.vehicles[v].has_start()) {
+        has_previous_step = true;
+        p_index = _input.vehicles[v].start.value().index();
+        previous_cost = _m[p_index][pickup_index];
+      }
     }
-    previous_cost = _m[p_index][c_index];
-  }
 
-  edges_costs_around = previous_cost + next_cost;
-  edge_costs_around_edge[v][last_edge_rank] = edges_costs_around;
+    // Compute cost for step after delivery.
+    bool has_next_step = false;
+    if (delivery_rank < route.size() - 1) {
+      has_next_step = true;
+      n_index = _input.jobs[route[delivery_rank + 1]].index();
+      next_cost = _m[delivery_index][n_index];
+    } else {
+      if (_input.vehicles[v].has_end()) {
+        has_next_step = true;
+        n_index = _input.vehicles[v].end.value().index();
+        next_cost = _m[delivery_index][n_index];
+      }
+    }
 
-  current_gain = edges_costs_around - new_edge_cost;
-  edge_gains[v][last_edge_rank] = current_gain;
+    if (has_previous_step and has_next_step and (route.size() > 2)) {
+      // No new edge with an open trip or if removing P&D creates an
+      // empty route.
+      new_edge_cost = _m[p_index][n_index];
+    }
 
-  if (current_gain > best_gain) {
-    edge_candidates[v] = last_edge_rank;
+    pd_gains[v][pickup_rank] = previous_cost +
+                               _m[pickup_index][delivery_index] + next_cost -
+                               new_edge_cost;
+  } else {
+    // Simply add both gains as neighbouring edges are disjoint.
+    pd_gains[v][pickup_rank] =
+      node_gains[v][pickup_rank] + node_gains[v][delivery_rank];
   }
 }
 
@@ -382,62 +508,33 @@ void SolutionState::set_pd_gains(const std::vector<Index>& route, Index v) {
   pd_gains[v] = std::vector<Gain>(route.size());
 
   for (std::size_t pickup_rank = 0; pickup_rank < route.size(); ++pickup_rank) {
-    if (_input.jobs[route[pickup_rank]].type != JOB_TYPE::PICKUP) {
-      continue;
+    if (_input.jobs[route[pickup_rank]].type == JOB_TYPE::PICKUP) {
+      set_pd_gain(route, v, pickup_rank);
     }
-    Index pickup_index = _input.jobs[route[pickup_rank]].index();
-    unsigned delivery_rank = matching_delivery_rank[v][pickup_rank];
-    Index delivery_index = _input.jobs[route[delivery_rank]].index();
-
-    if (pickup_rank + 1 == delivery_rank) {
-      // Pickup and delivery in a row.
-      Gain previous_cost = 0;
-      Gain next_cost = 0;
-      Gain new_edge_cost = 0;
-      Index p_index;
-      Index n_index;
-
-      // Compute cost for step before pickup.
-      bool has_previous_step = false;
-      if (pickup_rank > 0) {
-        has_previous_step = true;
-        p_index = _input.jobs[route[pickup_rank - 1]].index();
-        previous_cost = _m[p_index][pickup_index];
-      } else {
-        if (_input.vehicles[v].has_start()) {
-          has_previous_step = true;
-          p_index = _input.vehicles[v].start.value().index();
-          previous_cost = _m[p_index][pickup_index];
-        }
-      }
-
-      // Compute cost for step after delivery.
-      bool has_next_step = false;
-      if (delivery_rank < route.size() - 1) {
-        has_next_step = true;
-        n_index = _input.jobs[route[delivery_rank + 1]].index();
-        next_cost = _m[delivery_index][n_index];
-      } else {
-        if (_input.vehicles[v].has_end()) {
-          has_next_step = true;
-          n_index = _input.vehicles[v].end.value().index();
-          next_cost = _m[delivery_index][n_index];
-        }
-      }
-
-      if (has_previous_step and has_next_step and (route.size() > 2)) {
-        // No new edge with an open trip or if removing P&D creates an
-        // empty route.
-        new_edge_cost = _m[p_index][n_index];
-      }
+  }
+}
 
-      pd_gains[v][pickup_rank] = previous_cost +
-                                 _m[pickup_index][delivery_index] + next_cost -
-                                 new_edge_cost;
-    } else {
-      // Simply add both gains as neighbouring edges are disjoint.
-      pd_gains[v][pickup_rank] =
-        node_gains[v][pickup_rank] + node_gains[v][delivery_rank];
+void SolutionState::set_pd_gains(const std::vector<Index>& route,
+                                 Index v,
+                                 Index first_rank,
+                                 Index new_last_rank) {
+  resize_at(pd_gains[v], first_rank, route.size());
+
+  // Gains only change for pickups or deliveries whose node gain has
+  // been updated in set_node_gains.
+  const std::size_t begin = (first_rank > 0) ? first_rank - 1 : 0;
+  const std::size_t end =
+    std::min(static_cast<std::size_t>(new_last_rank) + 1, route.size());
+  for (std::size_t i = begin; i < end; ++i) {
+    switch (_input.jobs[route[i]].type) {
+    case JOB_TYPE::SINGLE:
+      break;
+    case JOB_TYPE::PICKUP:
+      set_pd_gain(route, v, i);
+      break;
+    case JOB_TYPE::DELIVERY:
+      set_pd_gain(route, v, matching_pickup_rank[v][i]);
+      break;
     }
   }
 }
@@ -479,13 +576,103 @@ void SolutionState::set_pd_matching_ranks(const std::vector<Index>& route,
   }
 }
 
-void SolutionState::update_nearest_job_rank_in_routes(
-  const std::vector<Index>& route_1,
-  const std::vector<Index>& route_2,
-  Index v1,
-  Index v2) {
-  nearest_job_rank_in_routes_from[v1][v2].assign(route_1.size(), 0);
-  nearest_job_rank_in_routes_to[v1][v2].assign(route_1.size(), 0);
+void SolutionState::set_pd_matching_ranks(const std::vector<Index>& route,
+                                          Index v,
+                                          Index first_rank,
+                                          Index old_last_rank,
+                                          Index new_last_rank) {
+  auto& delivery_ranks = matching_delivery_rank[v];
+  auto& pickup_ranks = matching_pickup_rank[v];
+  resize_at(delivery_ranks, first_rank, route.size());
+  resize_at(pickup_ranks, first_rank, route.size());
+
+  if (!_input.has_shipments()) {
+    return;
+  }
+
+  std::unordered_map<Index, Index> input_rank_to_new_route_rank;
+  for (std::size_t i = first_rank; i < new_last_rank; ++i) {
+    input_rank_to_new_route_rank.insert({route[i], i});
+  }
+
+  // Get current rank for job with input rank j that used to be at
+  // old_rank, based on where old_rank lies wrt modified range.
+  const auto current_rank = [&](Index old_rank, Index j) -> Index {
+    if (old_rank < first_rank) {
+      return old_rank;
+    }
+    if (old_rank >= old_last_rank) {
+      return old_rank - old_last_rank + new_last_rank;
+    }
+    auto search = input_rank_to_new_route_rank.find(j);
+    assert(search != input_rank_to_new_route_rank.end());
+    return search->second;
+  };
+
+  // Pickups before modified range and deliveries after modified range
+  // may have their matching job moved. Relies of the fact that
+  // associated pickup and delivery are stored sequentially in input
+  // jobs vector.
+  for (std::size_t i = 0; i < first_rank; ++i) {
+    if (_input.jobs[route[i]].type == JOB_TYPE::PICKUP) {
+      const auto delivery_rank = current_rank(delivery_ranks[i], route[i] + 1);
+      delivery_ranks[i] = delivery_rank;
+      pickup_ranks[delivery_rank] = i;
+    }
+  }
+
+  for (std::size_t i = new_last_rank; i < route.size(); ++i) {
+    if (_input.jobs[route[i]].type == JOB_TYPE::DELIVERY) {
+      const auto pickup_rank = current_rank(pickup_ranks[i], route[i] - 1);
+      pickup_ranks[i] = pickup_rank;
+      delivery_ranks[pickup_rank] = i;
+    }
+  }
+
+  // Remaining pairs are fully in modified range.
+  for (std::size_t i = first_rank; i < new_last_rank; ++i) {
+    if (_input.jobs[route[i]].type == JOB_TYPE::PICKUP) {
+      auto search = input_rank_to_new_route_rank.find(route[i] + 1);
+      if (search != input_rank_to_new_route_rank.end()) {
+        delivery_ranks[i] = search->second;
+        pickup_ranks[search->second] = i;
+      }
+    }
+  }
+}
+
+std::size_t
+SolutionState::nearest_ranks_offset(Index v1,
+                                    Index v2,
+                                    const std::vector<Index>& route_1,
+                                    const std::vector<Index>& route_2) {
+  assert(v1 != v2);
+  auto& block = _nearest_ranks_blocks[v1 * _nb_vehicles + v2];
+  if (block.computed and block.v1_version == _route_versions[v1] and
+      block.v2_version == _route_versions[v2]) {
+    return block.offset;
+  }
+
+  assert(!route_2.empty());
+
+  const std::size_t size = 2 * route_1.size();
+  if (!block.computed or block.capacity < size) {
+    if (block.computed) {
+      _nearest_ranks_arena_used -= block.capacity;
+    }
+    if (_nearest_ranks_arena.size() > 2 * _nearest_ranks_arena_used) {
+      // Mostly unused arena: drop all blocks instead of growing.
+      for (auto& b : _nearest_ranks_blocks) {
+        b.computed = false;
+      }
+      _nearest_ranks_arena.clear();
+      _nearest_ranks_arena_used = 0;
+    }
+    block.offset = _nearest_ranks_arena.size();
+    block.capacity = size;
+    _nearest_ranks_arena.resize(_nearest_ranks_arena.size() + size);
+    _nearest_ranks_arena_used += size;
+  }
 
   for (std::size_t r1 = 0; r1 < route_1.size(); ++r1) {
     Index index_r1 = _input.jobs[route_1[r1]].index();
@@ -507,9 +694,15 @@ void SolutionState::update_nearest_job_rank_in_routes(
       }
     }
 
-    nearest_job_rank_in_routes_from[v1][v2][r1] = best_from_rank;
-    nearest_job_rank_in_routes_to[v1][v2][r1] = best_to_rank;
+    _nearest_ranks_arena[block.offset + 2 * r1] = best_from_rank;
+    _nearest_ranks_arena[block.offset + 2 * r1 + 1] = best_to_rank;
   }
+
+  block.v1_version = _route_versions[v1];
+  block.v2_version = _route_versions[v2];
+  block.computed = true;
+
+  return block.offset;
 }
 
 void SolutionState::update_route_cost(const std::vector<Index>& route,
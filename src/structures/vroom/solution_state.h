@@ -10,6 +10,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <mutex>
+#include <optional>
 #include <unordered_set>
 
 #include "structures/typedefs.h"
@@ -53,12 +55,102 @@ struct SolutionIndicators {
   }
 };
 
+// Best indicators found so far, shared between threads solving from
+// different seeds.
+class SharedIndicators {
+private:
+  mutable std::mutex _mutex;
+  std::optional<SolutionIndicators> _best;
+
+public:
+  void update(const SolutionIndicators& indicators) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_best.has_value() or indicators < _best.value()) {
+      _best = indicators;
+    }
+  }
+
+  std::optional<SolutionIndicators> get() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _best;
+  }
+};
+
 class SolutionState {
 private:
   const Input& _input;
   const Matrix<Cost>& _m;
   const std::size_t _nb_vehicles;
 
+  // Incremented each time a route is modified.
+  std::vector<unsigned> _route_versions;
+
+  // Nearest job ranks for all (v1, v2) pairs are computed lazily and
+  // stored in a flat arena. A block holds interleaved from/to ranks
+  // for all jobs in route v1 and is valid as long as none of the
+  // routes has been modified since it was computed.
+  struct NearestRanksBlock {
+    std::size_t offset{0};
+    std::size_t capacity{0};
+    unsigned v1_version{0};
+    unsigned v2_version{0};
+    bool computed{false};
+  };
+  std::vector<NearestRanksBlock> _nearest_ranks_blocks;
+  std::vector<Index> _nearest_ranks_arena;
+  // Arena size used by allocated blocks, the rest being left over by
+  // blocks that had to grow.
+  std::size_t _nearest_ranks_arena_used;
+
+  // Return offset in arena for up-to-date block for (v1, v2).
+  std::size_t nearest_ranks_offset(Index v1,
+                                   Index v2,
+                                   const std::vector<Index>& route_1,
+                                   const std::vector<Index>& route_2);
+
+  // Set gains and edge costs for job at rank i (resp. edge starting
+  // at rank i, pickup at rank i) in route for vehicle v.
+  void set_node_gain(const std::vector<Index>& route, Index v, Index i);
+  void set_edge_gain(const std::vector<Index>& route, Index v, Index i);
+  void set_pd_gain(const std::vector<Index>& route, Index v, Index i);
+
+  // Range-based counterparts of the functions below, assuming jobs
+  // in [first_rank; old_last_rank) of the previous route for vehicle
+  // v have been replaced with jobs now in [first_rank;
+  // new_last_rank). Only values that may have changed are recomputed
+  // while other values are shifted accordingly.
+  void update_costs(const std::vector<Index>& route,
+                    Index v,
+                    Index first_rank,
+                    Index new_last_rank);
+
+  void update_skills(const std::vector<Index>& route,
+                     Index v1,
+                     Index first_rank,
+                     Index old_last_rank,
+                     Index new_last_rank);
+
+  void set_node_gains(const std::vector<Index>& route,
+                      Index v,
+                      Index first_rank,
+                      Index new_last_rank);
+
+  void set_edge_gains(const std::vector<Index>& route,
+                      Index v,
+                      Index first_rank,
+                      Index new_last_rank);
+
+  void set_pd_matching_ranks(const std::vector<Index>& route,
+                             Index v,
+                             Index first_rank,
+                             Index old_last_rank,
+                             Index new_last_rank);
+
+  void set_pd_gains(const std::vector<Index>& route,
+                    Index v,
+                    Index first_rank,
+                    Index new_last_rank);
+
 public:
   // Store unassigned jobs.
   std::unordered_set<Index> unassigned;
@@ -112,13 +204,6 @@ public:
   std::vector<std::vector<Index>> matching_delivery_rank;
   std::vector<std::vector<Index>> matching_pickup_rank;
 
-  // nearest_job_rank_in_routes_from[v1][v2][r1] stores the rank of
-  // job in route v2 that minimize cost from job at rank r1 in v1.
-  std::vector<std::vector<std::vector<Index>>> nearest_job_rank_in_routes_from;
-  // nearest_job_rank_in_routes_to[v1][v2][r1] stores the rank of job
-  // in route v2 that minimize cost to job at rank r1 in v1.
-  std::vector<std::vector<std::vector<Index>>> nearest_job_rank_in_routes_to;
-
   // Only used for assertions in debug mode.
   std::vector<Cost> route_costs;
 
@@ -130,6 +215,15 @@ public:
 
   void setup(const TWSolution& tw_sol);
 
+  // Update all values for route v after jobs in [first_rank;
+  // old_last_rank) of the previous route have been replaced with jobs
+  // now in [first_rank; new_last_rank).
+  void update(const std::vector<Index>& route,
+              Index v,
+              Index first_rank,
+              Index old_last_rank,
+              Index new_last_rank);
+
   void update_costs(const std::vector<Index>& route, Index v);
 
   void update_skills(const std::vector<Index>& route, Index v1);
@@ -142,10 +236,27 @@ public:
 
   void set_pd_matching_ranks(const std::vector<Index>& route, Index v);
 
-  void update_nearest_job_rank_in_routes(const std::vector<Index>& route_1,
-                                         const std::vector<Index>& route_2,
-                                         Index v1,
-                                         Index v2);
+  // Rank of job in route_2 (for v2) that minimizes cost from
+  // (resp. to) job at rank r1 in route_1 (for v1). Computed on first
+  // request for each (v1, v2) pair, then cached until route v1 or v2
+  // is updated. Route v2 should not be empty.
+  Index nearest_job_rank_in_route_from(Index v1,
+                                       Index v2,
+                                       const std::vector<Index>& route_1,
+                                       const std::vector<Index>& route_2,
+                                       Index r1) {
+    const auto offset = nearest_ranks_offset(v1, v2, route_1, route_2);
+    return _nearest_ranks_arena[offset + 2 * r1];
+  }
+
+  Index nearest_job_rank_in_route_to(Index v1,
+                                     Index v2,
+                                     const std::vector<Index>& route_1,
+                                     const std::vector<Index>& route_2,
+                                     Index r1) {
+    const auto offset = nearest_ranks_offset(v1, v2, route_1, route_2);
+    return _nearest_ranks_arena[offset + 2 * r1 + 1];
+  }
 
   void update_route_cost(const std::vector<Index>& route, Index v);
 };
@@ -8,12 +8,62 @@ All rights reserved (see LICENSE).
 */
 
 #include <algorithm>
+#include <limits>
 
 #include "structures/vroom/tw_route.h"
 #include "utils/exception.h"
 
 namespace vroom {
 
+TWSegment::TWSegment()
+  : earliest(0),
+    latest(std::numeric_limits<Duration>::max()),
+    duration(0),
+    feasible(true),
+    exact(true) {
+}
+
+TWSegment::TWSegment(const Job& j)
+  : earliest(j.tws.front().start),
+    latest(j.tws.front().end),
+    duration(j.service),
+    feasible(true),
+    exact(j.tws.size() == 1) {
+}
+
+TWSegment TWSegment::concatenate(const TWSegment& first,
+                                 const Duration travel,
+                                 const TWSegment& second) {
+  TWSegment s;
+  s.feasible = first.feasible and second.feasible;
+  s.exact = first.exact and second.exact;
+  if (!s.feasible or !s.exact) {
+    return s;
+  }
+
+  // Time from service start at first sequence to arrival at second
+  // sequence, when not waiting in first sequence.
+  const Duration offset = first.duration + travel;
+  if (second.latest < first.earliest + offset) {
+    s.feasible = false;
+    return s;
+  }
+
+  s.latest = std::min(first.latest, second.latest - offset);
+  s.earliest = (offset < second.earliest)
+                 ? std::max(first.earliest, second.earliest - offset)
+                 : first.earliest;
+  s.duration = offset + second.duration;
+
+  if (s.latest < s.earliest) {
+    // Any feasible start implies waiting until earliest.
+    s.duration += s.earliest - s.latest;
+    s.earliest = s.latest;
+  }
+
+  return s;
+}
+
 TWRoute::TWRoute(const Input& input, Index v)
   : RawRoute(input, v),
     v_start(input.vehicles[v].tw.start),
@@ -23,7 +73,10 @@ TWRoute::TWRoute(const Input& input, Index v)
     break_earliest(input.vehicles[v].breaks.size()),
     break_latest(input.vehicles[v].breaks.size()),
     breaks_travel_margin_before(input.vehicles[v].breaks.size()),
-    breaks_travel_margin_after(input.vehicles[v].breaks.size()) {
+    breaks_travel_margin_after(input.vehicles[v].breaks.size()),
+    suffix_segments(1),
+    reversed_suffix_segments(1),
+    reversed_prefix_segments(1) {
   std::string break_error = "Inconsistent breaks for vehicle " +
                             std::to_string(input.vehicles[v].id) + ".";
 
@@ -328,6 +381,51 @@ void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
   }
 }
 
+void TWRoute::update_segments(const Input& input) {
+  const auto& m = input.get_matrix();
+  const auto n = route.size();
+
+  suffix_segments.resize(n + 1);
+  reversed_suffix_segments.resize(n + 1);
+  reversed_prefix_segments.resize(n + 1);
+
+  suffix_segments[n] = TWSegment();
+  reversed_suffix_segments[n] = TWSegment();
+  reversed_prefix_segments[0] = TWSegment();
+  if (n == 0) {
+    return;
+  }
+
+  const auto& last_job = input.jobs[route[n - 1]];
+  suffix_segments[n - 1] = TWSegment(last_job);
+  reversed_suffix_segments[n - 1] = suffix_segments[n - 1];
+  for (Index i = n - 1; i > 0; --i) {
+    const auto& job = input.jobs[route[i - 1]];
+    const auto& next_job = input.jobs[route[i]];
+    const TWSegment job_segment(job);
+
+    suffix_segments[i - 1] =
+      TWSegment::concatenate(job_segment,
+                             m[job.index()][next_job.index()],
+                             suffix_segments[i]);
+    reversed_suffix_segments[i - 1] =
+      TWSegment::concatenate(reversed_suffix_segments[i],
+                             m[next_job.index()][job.index()],
+                             job_segment);
+  }
+
+  reversed_prefix_segments[1] = TWSegment(input.jobs[route[0]]);
+  for (Index i = 1; i < n; ++i) {
+    const auto& job = input.jobs[route[i]];
+    const auto& previous_job = input.jobs[route[i - 1]];
+
+    reversed_prefix_segments[i + 1] =
+      TWSegment::concatenate(TWSegment(job),
+                             m[job.index()][previous_job.index()],
+                             reversed_prefix_segments[i]);
+  }
+}
+
 OrderChoice::OrderChoice(const Job& j,
                          const Break& b,
                          const Duration current_earliest,
@@ -450,10 +548,9 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   const Index last_break = breaks_counts[rank];
 
   while (!job_added or current_break != last_break) {
-    const auto& b = v.breaks[current_break];
-
     if (job_added) {
       // Compute earliest end date for current break.
+      const auto& b = v.breaks[current_break];
       const auto b_tw =
         std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
           return current_earliest <= tw.end;
@@ -498,6 +595,7 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     }
 
     // Decide on ordering between break and added job.
+    const auto& b = v.breaks[current_break];
     auto oc = order_choice(j, b, current_earliest, previous_travel);
 
     if (!oc.add_job_first and !oc.add_break_first) {
@@ -702,6 +800,43 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   return current_earliest + next_travel <= current_latest;
 }
 
+template <class InputIterator>
+bool TWRoute::is_valid_addition_for_tw(const Input& input,
+                                       const TWSegment& segment,
+                                       const InputIterator first_job,
+                                       const InputIterator last_job,
+                                       const Index first_rank,
+                                       const Index last_rank) const {
+  const auto& v = input.vehicles[vehicle_rank];
+  if (!v.breaks.empty() or first_job == last_job or !segment.exact) {
+    return is_valid_addition_for_tw(input,
+                                    first_job,
+                                    last_job,
+                                    first_rank,
+                                    last_rank);
+  }
+
+  if (!segment.feasible) {
+    return false;
+  }
+
+  // Without breaks, earliest end at previous rank and latest start at
+  // last rank summarize the route prefix and suffix.
+  Duration previous_travel = 0;
+  const Duration arrival =
+    previous_earliest_end(input, *first_job, first_rank, previous_travel) +
+    previous_travel;
+
+  Duration next_travel = 0;
+  const Duration next_start =
+    next_latest_start(input, *(last_job - 1), last_rank, next_travel);
+
+  return arrival <= segment.latest and
+         std::max(arrival, segment.earliest) + segment.duration +
+             next_travel <=
+           next_start;
+}
+
 void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
   assert(rank <= route.size());
 
@@ -832,7 +967,8 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
   fwd_update_earliest_from(input, rank);
   bwd_update_latest_from(input, rank);
 
-  update_amounts(input);
+  update_amounts(input, rank, rank, rank + 1);
+  update_segments(input);
 }
 
 bool TWRoute::is_valid_removal(const Input& input,
@@ -925,10 +1061,11 @@ void TWRoute::replace(const Input& input,
   const unsigned erase_count = last_rank - first_rank;
   const unsigned add_count = std::distance(first_job, last_job);
 
-  // Update data structures. For earliest and latest dates, we need to
-  // overwrite old values. Otherwise they may happen to be identical
-  // to new computed values and stop propagation inside
-  // fwd_update_earliest_from and bwd_update_latest_from below.
+  // Update data structures, only shifting values when the route size
+  // changes. Earliest dates in [first_rank, first_rank + add_count)
+  // are overwritten by the loop below. Latest dates there are reset
+  // to 0 so that bwd_update_latest_from can't stop early on a stale
+  // value equal to the new one.
   if (add_count < erase_count) {
     auto to_erase = erase_count - add_count;
     route.erase(route.begin() + first_rank,
@@ -943,21 +1080,8 @@ void TWRoute::replace(const Input& input,
                          breaks_at_rank.begin() + first_rank + to_erase);
     breaks_counts.erase(breaks_counts.begin() + first_rank,
                         breaks_counts.begin() + first_rank + to_erase);
-
-    std::fill(earliest.begin() + first_rank,
-              earliest.begin() + first_rank + add_count,
-              std::numeric_limits<Duration>::max());
-    std::fill(latest.begin() + first_rank,
-              latest.begin() + first_rank + add_count,
-              0);
-  } else {
-    std::fill(earliest.begin() + first_rank,
-              earliest.begin() + first_rank + erase_count,
-              std::numeric_limits<Duration>::max());
-    std::fill(latest.begin() + first_rank,
-              latest.begin() + first_rank + erase_count,
-              0);
-
+  }
+  if (erase_count < add_count) {
     auto to_insert = add_count - erase_count;
     route.insert(route.begin() + first_rank, to_insert, 0);
     earliest.insert(earliest.begin() + first_rank, to_insert, 0);
@@ -966,6 +1090,9 @@ void TWRoute::replace(const Input& input,
     breaks_at_rank.insert(breaks_at_rank.begin() + first_rank, to_insert, 0);
     breaks_counts.insert(breaks_counts.begin() + first_rank, to_insert, 0);
   }
+  std::fill(latest.begin() + first_rank,
+            latest.begin() + first_rank + add_count,
+            0);
 
   // Current rank in route/earliest/latest/tw_ranks vectors.
   Index current_job_rank = first_rank;
@@ -1177,7 +1304,8 @@ void TWRoute::replace(const Input& input,
     bwd_update_latest_from(input, current_job_rank);
   }
 
-  update_amounts(input);
+  update_amounts(input, first_rank, last_rank, first_rank + add_count);
+  update_segments(input);
 }
 
 template bool
@@ -1193,6 +1321,21 @@ template bool TWRoute::is_valid_addition_for_tw(
   const Index first_rank,
   const Index last_rank) const;
 
+template bool
+TWRoute::is_valid_addition_for_tw(const Input& input,
+                                  const TWSegment& segment,
+                                  const std::vector<Index>::iterator first_job,
+                                  const std::vector<Index>::iterator last_job,
+                                  const Index first_rank,
+                                  const Index last_rank) const;
+template bool TWRoute::is_valid_addition_for_tw(
+  const Input& input,
+  const TWSegment& segment,
+  const std::vector<Index>::reverse_iterator first_job,
+  const std::vector<Index>::reverse_iterator last_job,
+  const Index first_rank,
+  const Index last_rank) const;
+
 template void TWRoute::replace(const Input& input,
                                const std::vector<Index>::iterator first_job,
                                const std::vector<Index>::iterator last_job,
@@ -31,6 +31,28 @@ struct OrderChoice {
               const Duration previous_travel);
 };
 
+// Time window data for a sequence of jobs served without breaks,
+// allowing constant-time concatenation (see Vidal et al., 2013).
+// Service at first job can start at any date up to latest, then the
+// whole sequence ends at max(start, earliest) + duration, including
+// waiting times. Only exact if all jobs have a single time window.
+struct TWSegment {
+  Duration earliest;
+  Duration latest;
+  Duration duration;
+  bool feasible;
+  bool exact;
+
+  TWSegment();
+
+  TWSegment(const Job& j);
+
+  // Sequence made of first, then travel, then second.
+  static TWSegment concatenate(const TWSegment& first,
+                               const Duration travel,
+                               const TWSegment& second);
+};
+
 class TWRoute : public RawRoute {
 private:
   // When inserting job at job_rank in route at rank, retrieve
@@ -49,6 +71,8 @@ private:
   void fwd_update_earliest_from(const Input& input, Index rank);
   void bwd_update_latest_from(const Input& input, Index rank);
 
+  void update_segments(const Input& input);
+
   // Define global policy wrt job/break respective insertion rule.
   OrderChoice order_choice(const Job& j,
                            const Break& b,
@@ -88,6 +112,13 @@ public:
   std::vector<Duration> breaks_travel_margin_before;
   std::vector<Duration> breaks_travel_margin_after;
 
+  // Segments for route[i:] in route order (resp. reversed) and for
+  // route[:i] reversed, with i in [0, route.size()], to check
+  // insertion of those sequences in other routes.
+  std::vector<TWSegment> suffix_segments;
+  std::vector<TWSegment> reversed_suffix_segments;
+  std::vector<TWSegment> reversed_prefix_segments;
+
   TWRoute(const Input& input, Index i);
 
   bool empty() const {
@@ -114,6 +145,17 @@ public:
                                 const Index first_rank,
                                 const Index last_rank) const;
 
+  // Same as above when segment holds time window data for the range,
+  // e.g. from another route segments. Checked in constant time for
+  // vehicles without breaks.
+  template <class InputIterator>
+  bool is_valid_addition_for_tw(const Input& input,
+                                const TWSegment& segment,
+                                const InputIterator first_job,
+                                const InputIterator last_job,
+                                const Index first_rank,
+                                const Index last_rank) const;
+
   void add(const Input& input, const Index job_rank, const Index rank);
 
   // Check validity for removing a set of jobs from current route at
@@ -23,6 +23,8 @@ struct Vehicle {
   std::optional<Location> start;
   std::optional<Location> end;
   const Amount capacity;
+  // Input data only, solving relies on the matching bitset stored
+  // in Input.
   const Skills skills;
   const TimeWindow tw;
   const std::vector<Break> breaks;
@@ -33,6 +33,11 @@ inline Cost add_without_overflow(Cost a, Cost b) {
   return a + b;
 }
 
+inline bool deadline_reached(const Deadline& deadline) {
+  return deadline.has_value() and
+         deadline.value() < std::chrono::high_resolution_clock::now();
+}
+
 inline INIT get_init(const std::string& s) {
   if (s == "NONE") {
     return INIT::NONE;
@@ -258,6 +263,48 @@ inline void check_tws(const std::vector<TimeWindow>& tws) {
   }
 }
 
+// Set route and steps distances from the distance matrix, breaks
+// distances being pro rata temporis within their route leg.
+inline void set_route_distances(const Matrix<Distance>& distances,
+                                Route& route) {
+  Distance sum_distance = 0;
+
+  // Rank of last non-break step, if any.
+  auto previous = route.steps.size();
+
+  for (std::size_t s = 0; s < route.steps.size(); ++s) {
+    auto& step = route.steps[s];
+    step.distance = sum_distance;
+    if (step.step_type == STEP_TYPE::BREAK) {
+      continue;
+    }
+
+    if (previous < route.steps.size()) {
+      const auto& previous_step = route.steps[previous];
+      const Distance leg =
+        distances[previous_step.location.index()][step.location.index()];
+      const Duration leg_duration = step.duration - previous_step.duration;
+
+      if (leg_duration > 0) {
+        for (auto b = previous + 1; b < s; ++b) {
+          auto& break_step = route.steps[b];
+          break_step.distance +=
+            (static_cast<uint64_t>(break_step.duration -
+                                   previous_step.duration) *
+             leg) /
+            leg_duration;
+        }
+      }
+
+      sum_distance += leg;
+      step.distance = sum_distance;
+    }
+    previous = s;
+  }
+
+  route.distance = sum_distance;
+}
+
 inline Solution format_solution(const Input& input,
                                 const RawSolution& raw_routes) {
   const auto& m = input.get_matrix();
@@ -382,6 +429,12 @@ inline Solution format_solution(const Input& input,
                  std::back_inserter(unassigned_jobs),
                  [&](auto j) { return input.jobs[j]; });
 
+  if (input.has_distance_matrix()) {
+    for (auto& route : routes) {
+      set_route_distances(input.get_distance_matrix(), route);
+    }
+  }
+
   return Solution(0,
                   input.zero_amount().size(),
                   std::move(routes),
@@ -731,6 +784,12 @@ inline Solution format_solution(const Input& input,
                  std::back_inserter(unassigned_jobs),
                  [&](auto j) { return input.jobs[j]; });
 
+  if (input.has_distance_matrix()) {
+    for (auto& route : routes) {
+      set_route_distances(input.get_distance_matrix(), route);
+    }
+  }
+
   return Solution(0,
                   input.zero_amount().size(),
                   std::move(routes),
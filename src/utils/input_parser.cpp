@@ -21,6 +21,7 @@ All rights reserved (see LICENSE).
 #if USE_LIBOSRM
 #include "routing/libosrm_wrapper.h"
 #endif
+#include "routing/matrix_cache.h"
 #include "routing/ors_wrapper.h"
 #include "routing/osrm_routed_wrapper.h"
 #include "structures/cl_args.h"
@@ -306,6 +307,9 @@ Input parse(const CLArgs& cl_args) {
   auto amount_size = get_amount_size(json_input);
   Input input(amount_size);
   input.set_geometry(cl_args.geometry);
+  input.set_distances(cl_args.distances);
+  input.set_seed_pruning(cl_args.seed_pruning);
+  input.set_nb_neighbours(cl_args.nb_neighbours);
 
   // Switch input type: explicit matrix or using OSRM.
   if (json_input.HasMember("matrix")) {
@@ -639,6 +643,8 @@ Input parse(const CLArgs& cl_args) {
 
   // Set relevant routing wrapper.
   std::unique_ptr<routing::Wrapper> routing_wrapper;
+  // Routing engine and server, used to key cached matrices.
+  std::string routing_source;
   switch (cl_args.router) {
   case ROUTER::OSRM: {
     // Use osrm-routed.
@@ -649,6 +655,7 @@ Input parse(const CLArgs& cl_args) {
     routing_wrapper =
       std::make_unique<routing::OsrmRoutedWrapper>(common_profile,
                                                    search->second);
+    routing_source = "osrm_" + search->second.host + "_" + search->second.port;
   } break;
   case ROUTER::LIBOSRM:
 #if USE_LIBOSRM
@@ -656,6 +663,7 @@ Input parse(const CLArgs& cl_args) {
     try {
       routing_wrapper =
         std::make_unique<routing::LibosrmWrapper>(common_profile);
+      routing_source = "libosrm";
     } catch (const osrm::exception& e) {
       throw Exception(ERROR::ROUTING,
                       "Invalid shared memory region: " + common_profile);
@@ -674,8 +682,23 @@ Input parse(const CLArgs& cl_args) {
     }
     routing_wrapper =
       std::make_unique<routing::OrsWrapper>(common_profile, search->second);
+    routing_source = "ors_" + search->second.host + "_" + search->second.port;
     break;
   }
+
+  if (routing_wrapper) {
+    routing_wrapper->set_matrix_tiling(cl_args.matrix_tile_size,
+                                       cl_args.nb_threads);
+  }
+
+  if (!cl_args.matrix_cache_dir.empty()) {
+    // Durations from the routing engine go through the on-disk cache.
+    routing_wrapper =
+      std::make_unique<routing::MatrixCache>(std::move(routing_wrapper),
+                                             cl_args.matrix_cache_dir,
+                                             routing_source);
+  }
+
   input.set_routing(std::move(routing_wrapper));
 
   return input;
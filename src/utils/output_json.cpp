@@ -19,7 +19,9 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace io {
 
-rapidjson::Document to_json(const Solution& sol, bool geometry) {
+rapidjson::Document to_json(const Solution& sol,
+                            bool geometry,
+                            bool distances) {
   rapidjson::Document json_output;
   json_output.SetObject();
   rapidjson::Document::AllocatorType& allocator = json_output.GetAllocator();
@@ -30,7 +32,7 @@ rapidjson::Document to_json(const Solution& sol, bool geometry) {
     json_output["error"].SetString(sol.error.c_str(), sol.error.size());
   } else {
     json_output.AddMember("summary",
-                          to_json(sol.summary, geometry, allocator),
+                          to_json(sol.summary, geometry, distances, allocator),
                           allocator);
 
     rapidjson::Value json_unassigned(rapidjson::kArrayType);
@@ -49,7 +51,7 @@ rapidjson::Document to_json(const Solution& sol, bool geometry) {
 
     rapidjson::Value json_routes(rapidjson::kArrayType);
     for (const auto& route : sol.routes) {
-      json_routes.PushBack(to_json(route, geometry, allocator), allocator);
+      json_routes.PushBack(to_json(route, distances, allocator), allocator);
     }
 
     json_output.AddMember("routes", json_routes, allocator);
@@ -60,6 +62,7 @@ rapidjson::Document to_json(const Solution& sol, bool geometry) {
 
 rapidjson::Value to_json(const Summary& summary,
                          bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator) {
   rapidjson::Value json_summary(rapidjson::kObjectType);
 
@@ -93,7 +96,7 @@ rapidjson::Value to_json(const Summary& summary,
   json_summary.AddMember("duration", summary.duration, allocator);
   json_summary.AddMember("waiting_time", summary.waiting_time, allocator);
 
-  if (geometry) {
+  if (distances) {
     json_summary.AddMember("distance", summary.distance, allocator);
   }
 
@@ -105,7 +108,7 @@ rapidjson::Value to_json(const Summary& summary,
 }
 
 rapidjson::Value to_json(const Route& route,
-                         bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator) {
   rapidjson::Value json_route(rapidjson::kObjectType);
 
@@ -139,13 +142,13 @@ rapidjson::Value to_json(const Route& route,
   json_route.AddMember("duration", route.duration, allocator);
   json_route.AddMember("waiting_time", route.waiting_time, allocator);
 
-  if (geometry) {
+  if (distances) {
     json_route.AddMember("distance", route.distance, allocator);
   }
 
   rapidjson::Value json_steps(rapidjson::kArrayType);
   for (const auto& step : route.steps) {
-    json_steps.PushBack(to_json(step, geometry, allocator), allocator);
+    json_steps.PushBack(to_json(step, distances, allocator), allocator);
   }
 
   json_route.AddMember("steps", json_steps, allocator);
@@ -176,7 +179,7 @@ rapidjson::Value to_json(const ComputingTimes& ct,
 }
 
 rapidjson::Value to_json(const Step& s,
-                         bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator) {
   rapidjson::Value json_step(rapidjson::kObjectType);
 
@@ -234,7 +237,7 @@ rapidjson::Value to_json(const Step& s,
   json_step.AddMember("arrival", s.arrival, allocator);
   json_step.AddMember("duration", s.duration, allocator);
 
-  if (geometry) {
+  if (distances) {
     json_step.AddMember("distance", s.distance, allocator);
   }
 
@@ -253,8 +256,9 @@ rapidjson::Value to_json(const Location& loc,
 
 void write_to_json(const Solution& sol,
                    bool geometry,
+                   bool distances,
                    const std::string& output_file) {
-  auto json_output = to_json(sol, geometry);
+  auto json_output = to_json(sol, geometry, distances);
 
   // Rapidjson writing process.
   rapidjson::StringBuffer s;
@@ -18,10 +18,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace io {
 
-rapidjson::Document to_json(const Solution& sol, bool geometry);
+rapidjson::Document to_json(const Solution& sol, bool geometry, bool distances);
 
 rapidjson::Value to_json(const Summary& summary,
                          bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator);
 
 rapidjson::Value to_json(const ComputingTimes& computing_times,
@@ -29,11 +30,11 @@ rapidjson::Value to_json(const ComputingTimes& computing_times,
                          rapidjson::Document::AllocatorType& allocator);
 
 rapidjson::Value to_json(const Route& route,
-                         bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator);
 
 rapidjson::Value to_json(const Step& s,
-                         bool geometry,
+                         bool distances,
                          rapidjson::Document::AllocatorType& allocator);
 
 rapidjson::Value to_json(const Location& loc,
@@ -41,6 +42,7 @@ rapidjson::Value to_json(const Location& loc,
 
 void write_to_json(const Solution& sol,
                    bool geometry,
+                   bool distances,
                    const std::string& output_file);
 
 } // namespace io
@@ -0,0 +1,184 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "utils/exception.h"
+#include "utils/thread_pool.h"
+
+namespace vroom {
+namespace utils {
+
+const std::size_t ThreadPool::DEFAULT_MAX_QUEUE_SIZE = 1024;
+
+namespace {
+
+std::mutex shared_config_mutex;
+bool shared_in_use = false;
+unsigned shared_max_workers = std::max(1u, std::thread::hardware_concurrency());
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned max_workers, std::size_t max_queue_size)
+  : _nb_busy(0),
+    _max_workers(max_workers),
+    _max_queue_size(std::max<std::size_t>(max_queue_size, 1)),
+    _stop(false) {
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _task_available.notify_all();
+
+  for (auto& w : _workers) {
+    w.join();
+  }
+}
+
+void ThreadPool::set_shared_max_workers(unsigned max_workers) {
+  std::lock_guard<std::mutex> lock(shared_config_mutex);
+  if (shared_in_use) {
+    throw Exception(ERROR::INTERNAL, "Shared thread pool already in use.");
+  }
+  shared_max_workers = max_workers;
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool([] {
+    std::lock_guard<std::mutex> lock(shared_config_mutex);
+    shared_in_use = true;
+    return shared_max_workers;
+  }());
+  return pool;
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _task_available.wait(lock, [&] { return _stop or !_tasks.empty(); });
+      if (_tasks.empty()) {
+        // Stopping with nothing left to do.
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+      ++_nb_busy;
+    }
+
+    task();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_nb_busy;
+  }
+}
+
+unsigned ThreadPool::max_workers() const {
+  return _max_workers;
+}
+
+unsigned ThreadPool::submit_to_free_workers(const std::function<void()>& task,
+                                            unsigned nb_tasks) {
+  unsigned nb_submitted = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Queued tasks will be picked by idle workers first.
+    auto nb_free = [&]() -> std::size_t {
+      const auto nb_taken = _nb_busy + _tasks.size();
+      return (_workers.size() > nb_taken) ? _workers.size() - nb_taken : 0;
+    };
+
+    while (nb_free() < nb_tasks and _workers.size() < _max_workers) {
+      _workers.emplace_back(&ThreadPool::work, this);
+    }
+
+    const auto queue_room = _max_queue_size - std::min(_max_queue_size,
+                                                       _tasks.size());
+    nb_submitted =
+      std::min<std::size_t>({nb_tasks, nb_free(), queue_room});
+    for (unsigned i = 0; i < nb_submitted; ++i) {
+      _tasks.push_back(task);
+    }
+  }
+
+  for (unsigned i = 0; i < nb_submitted; ++i) {
+    _task_available.notify_one();
+  }
+  return nb_submitted;
+}
+
+void ThreadPool::parallel_for(std::size_t n,
+                              unsigned parallelism,
+                              const std::function<void(std::size_t)>& f) {
+  parallelism = std::min<std::size_t>(parallelism, n);
+  if (parallelism <= 1) {
+    for (std::size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  // Shared state is kept alive by helper tasks that may only start
+  // once all the work is done. Those never touch f since all indices
+  // have been claimed at that point.
+  struct Batch {
+    std::atomic<std::size_t> next;
+    std::size_t done;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable all_done;
+
+    Batch() : next(0), done(0) {
+    }
+  };
+  auto batch = std::make_shared<Batch>();
+
+  auto run = [batch, n, &f]() {
+    for (auto i = batch->next++; i < n; i = batch->next++) {
+      std::exception_ptr error;
+      try {
+        f(i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      if (error and !batch->error) {
+        batch->error = error;
+      }
+      if (++batch->done == n) {
+        batch->all_done.notify_all();
+      }
+    }
+  };
+
+  // Calling thread handles remaining work if fewer helpers than
+  // requested are free.
+  submit_to_free_workers(run, parallelism - 1);
+
+  run();
+
+  std::unique_lock<std::mutex> lock(batch->mutex);
+  batch->all_done.wait(lock, [&] { return batch->done == n; });
+
+  if (batch->error) {
+    std::rethrow_exception(batch->error);
+  }
+}
+
+} // namespace utils
+} // namespace vroom
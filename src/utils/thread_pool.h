@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2020, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vroom {
+namespace utils {
+
+// Pool of persistent worker threads fed through a bounded task
+// queue. Workers are only started when first required, up to
+// max_workers.
+class ThreadPool {
+private:
+  std::mutex _mutex;
+  std::condition_variable _task_available;
+  std::deque<std::function<void()>> _tasks;
+  std::vector<std::thread> _workers;
+  unsigned _nb_busy;
+  const unsigned _max_workers;
+  const std::size_t _max_queue_size;
+  bool _stop;
+
+  void work();
+
+  // Queue up to nb_tasks copies of task, only as many as there are
+  // workers free to run them (starting workers if required within
+  // max_workers limit). Return the number of queued copies.
+  unsigned submit_to_free_workers(const std::function<void()>& task,
+                                  unsigned nb_tasks);
+
+public:
+  static const std::size_t DEFAULT_MAX_QUEUE_SIZE;
+
+  ThreadPool(unsigned max_workers,
+             std::size_t max_queue_size = DEFAULT_MAX_QUEUE_SIZE);
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  // Set the number of workers for the shared pool, defaults to the
+  // number of available hardware threads. Throws if the shared pool
+  // is already in use.
+  static void set_shared_max_workers(unsigned max_workers);
+
+  // Pool shared by all solving code. Concurrent calls to
+  // Input::solve use the same workers, each one bounding its own use
+  // through the parallelism argument of parallel_for.
+  static ThreadPool& shared();
+
+  unsigned max_workers() const;
+
+  // Run f(i) for all i in [0, n) using the calling thread and up to
+  // parallelism - 1 workers, returning when all calls are done. Only
+  // workers free at call time are used. The calling thread always
+  // takes part so nested calls from inside a worker can't deadlock.
+  // First exception thrown by f (if any) is rethrown.
+  void parallel_for(std::size_t n,
+                    unsigned parallelism,
+                    const std::function<void(std::size_t)>& f);
+};
+
+} // namespace utils
+} // namespace vroom
+
+#endif